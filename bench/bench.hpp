@@ -0,0 +1,30 @@
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <cstddef>
+
+// Keeps the optimizer from dropping benchmarked work whose result is otherwise unused
+inline volatile size_t benchSink = 0;
+
+template <typename FUNC>
+double benchMeasureNs(size_t iterations, FUNC&& func)
+{
+    func();
+
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        func();
+    }
+    const auto finish = std::chrono::steady_clock::now();
+
+    return std::chrono::duration<double, std::nano>(finish - start).count() / static_cast<double>(iterations);
+}
+
+inline void benchReport(const char* name, size_t bytesPerIteration, size_t operationsPerIteration, double nsPerIteration)
+{
+    std::printf("%-56s %10.2f ns/op %8.2f GB/s\n",
+        name,
+        nsPerIteration / static_cast<double>(operationsPerIteration),
+        static_cast<double>(bytesPerIteration) / nsPerIteration);
+}
@@ -0,0 +1,470 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <list>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "restools/buffer_composer.hpp"
+#include "restools/remap_allocator.hpp"
+
+#include "bench.hpp"
+
+namespace
+{
+    // Overflow tier as it was before chunk blocks: one list node and one buffer per save
+    class ListChunksComposer
+    {
+    public:
+        ~ListChunksComposer()
+        {
+            clear();
+        }
+
+        void save(const unsigned char* buffer, size_t bufferSize)
+        {
+            chunks_.emplace_back();
+            Chunk& chunk = chunks_.back();
+            chunk.first = new unsigned char[bufferSize];
+            std::memcpy(chunk.first, buffer, bufferSize);
+            chunk.second = bufferSize;
+            savedCount_ += bufferSize;
+        }
+
+        const unsigned char* compose()
+        {
+            composed_ = new unsigned char[savedCount_];
+            size_t written = 0;
+            for (Chunk& chunk : chunks_) {
+                std::memcpy(composed_ + written, chunk.first, chunk.second);
+                written += chunk.second;
+                delete[]chunk.first;
+                chunk.first = nullptr;
+            }
+            chunks_.clear();
+            return composed_;
+        }
+
+        void clear()
+        {
+            for (Chunk& chunk : chunks_) {
+                delete[]chunk.first;
+            }
+            chunks_.clear();
+            delete[]composed_;
+            composed_ = nullptr;
+            savedCount_ = 0;
+        }
+
+    private:
+        using Chunk = std::pair<unsigned char*, size_t>;
+
+        std::list<Chunk> chunks_;
+        unsigned char* composed_ = nullptr;
+        size_t savedCount_ = 0;
+    };
+}
+
+void benchBufferComposerChunks()
+{
+    using namespace restools;
+
+    static constexpr size_t totalSize = 4 * 1024 * 1024;
+    std::vector<unsigned char> data(totalSize, 'x');
+
+    for (size_t saveSize : { 16, 64, 256, 1024, 4096 }) {
+        const size_t savesCount = totalSize / saveSize;
+        const size_t iterations = std::max<size_t>(4, 64 * 1024 / savesCount);
+        char name[96];
+
+        ListChunksComposer listComposer;
+        double listNs = benchMeasureNs(iterations, [&]()
+        {
+            for (size_t i = 0; i < savesCount; ++i) {
+                listComposer.save(data.data() + i * saveSize, saveSize);
+            }
+            benchSink = listComposer.compose()[0];
+            listComposer.clear();
+        });
+        std::snprintf(name, sizeof(name), "chunks list save+compose %zuB", saveSize);
+        benchReport(name, totalSize, savesCount, listNs);
+
+        buffer_composer<8, 2> composer(8, totalSize);
+        double blocksNs = benchMeasureNs(iterations, [&]()
+        {
+            for (size_t i = 0; i < savesCount; ++i) {
+                composer.save(data.data() + i * saveSize, saveSize);
+            }
+            unsigned char* composedData = nullptr;
+            size_t composedDataSize = 0;
+            composer.compose(composedData, composedDataSize);
+            benchSink = composedData[0];
+            composer.clear();
+        });
+        std::snprintf(name, sizeof(name), "chunk blocks save+compose %zuB", saveSize);
+        benchReport(name, totalSize, savesCount, blocksNs);
+    }
+}
+
+namespace
+{
+    enum class SaveSizeDistribution
+    {
+        Fixed16,
+        Fixed256,
+        Uniform1To512,
+        SmallWithLargeTail,
+    };
+
+    const char* saveSizeDistributionName(SaveSizeDistribution distribution)
+    {
+        switch (distribution) {
+        case SaveSizeDistribution::Fixed16: return "fixed 16B";
+        case SaveSizeDistribution::Fixed256: return "fixed 256B";
+        case SaveSizeDistribution::Uniform1To512: return "uniform 1-512B";
+        case SaveSizeDistribution::SmallWithLargeTail: return "8-64B, 10% 1-4KB";
+        }
+        return "";
+    }
+
+    // Save sizes summing to totalSize exactly
+    std::vector<size_t> makeSaveSizes(SaveSizeDistribution distribution, size_t totalSize)
+    {
+        std::mt19937 generator(42);
+        std::uniform_int_distribution<size_t> uniform(1, 512);
+        std::uniform_int_distribution<size_t> small(8, 64);
+        std::uniform_int_distribution<size_t> large(1024, 4096);
+        std::uniform_int_distribution<size_t> percent(0, 99);
+
+        std::vector<size_t> saveSizes;
+        size_t sizesTotal = 0;
+        while (sizesTotal < totalSize) {
+            size_t saveSize = 0;
+            switch (distribution) {
+            case SaveSizeDistribution::Fixed16: saveSize = 16; break;
+            case SaveSizeDistribution::Fixed256: saveSize = 256; break;
+            case SaveSizeDistribution::Uniform1To512: saveSize = uniform(generator); break;
+            case SaveSizeDistribution::SmallWithLargeTail: saveSize = percent(generator) < 10 ? large(generator) : small(generator); break;
+            }
+            saveSize = std::min(saveSize, totalSize - sizesTotal);
+            saveSizes.push_back(saveSize);
+            sizesTotal += saveSize;
+        }
+        return saveSizes;
+    }
+
+    size_t benchIterations(size_t totalSize)
+    {
+        return std::max<size_t>(8, 64 * 1024 * 1024 / (totalSize * 16));
+    }
+
+    double benchVectorAppend(const std::vector<unsigned char>& data, const std::vector<size_t>& saveSizes, bool keepCapacity)
+    {
+        std::vector<unsigned char> appended;
+        return benchMeasureNs(benchIterations(data.size()), [&]()
+        {
+            if (!keepCapacity) {
+                appended = std::vector<unsigned char>();
+            }
+            size_t offset = 0;
+            for (size_t saveSize : saveSizes) {
+                appended.insert(appended.end(), data.data() + offset, data.data() + offset + saveSize);
+                offset += saveSize;
+            }
+            benchSink = appended[appended.size() / 2];
+            appended.clear();
+        });
+    }
+
+    template <typename COMPOSER>
+    double benchComposerSaveCompose(COMPOSER& composer, const std::vector<unsigned char>& data,
+        const std::vector<size_t>& saveSizes, bool keepCapacity)
+    {
+        return benchMeasureNs(benchIterations(data.size()), [&]()
+        {
+            size_t offset = 0;
+            for (size_t saveSize : saveSizes) {
+                composer.save(data.data() + offset, saveSize);
+                offset += saveSize;
+            }
+            unsigned char* composedData = nullptr;
+            size_t composedDataSize = 0;
+            composer.compose(composedData, composedDataSize);
+            benchSink = composedData[composedDataSize / 2];
+            if (keepCapacity) {
+                composer.clear();
+            }
+            else {
+                composer.cleanup();
+            }
+        });
+    }
+}
+
+// Each tier against std::vector append of the same saves, both reusing their storage between iterations
+void benchBufferComposerTiers()
+{
+    using namespace restools;
+
+    struct Tier
+    {
+        const char* name;
+        size_t totalSize;
+    };
+
+    static constexpr size_t linearBufferMaxSize = 64 * 1024;
+    static constexpr Tier tiers[] = {
+        { "stack", 240 },
+        { "linear", 48 * 1024 },
+        { "chunks", 4 * 1024 * 1024 },
+    };
+
+    for (const Tier& tier : tiers) {
+        std::vector<unsigned char> data(tier.totalSize, 'x');
+
+        for (SaveSizeDistribution distribution : { SaveSizeDistribution::Fixed16, SaveSizeDistribution::Fixed256,
+            SaveSizeDistribution::Uniform1To512, SaveSizeDistribution::SmallWithLargeTail }) {
+            const std::vector<size_t> saveSizes = makeSaveSizes(distribution, tier.totalSize);
+            char name[96];
+
+            double vectorNs = benchVectorAppend(data, saveSizes, true);
+            std::snprintf(name, sizeof(name), "vector append %s %s", tier.name, saveSizeDistributionName(distribution));
+            benchReport(name, tier.totalSize, saveSizes.size(), vectorNs);
+
+            buffer_composer<> composer(linearBufferMaxSize, tier.totalSize);
+            double composerNs = benchComposerSaveCompose(composer, data, saveSizes, true);
+            std::snprintf(name, sizeof(name), "composer save+compose %s %s", tier.name, saveSizeDistributionName(distribution));
+            benchReport(name, tier.totalSize, saveSizes.size(), composerNs);
+        }
+    }
+}
+
+template <uint16_t LINEAR_BUFFER_MULTIPLIER>
+void benchBufferComposerGrowthWithMultiplier(const std::vector<unsigned char>& data, const std::vector<size_t>& saveSizes)
+{
+    using namespace restools;
+
+    buffer_composer<256, LINEAR_BUFFER_MULTIPLIER> composer(data.size(), data.size());
+    double composerNs = benchComposerSaveCompose(composer, data, saveSizes, false);
+    char name[96];
+    std::snprintf(name, sizeof(name), "composer linear growth multiplier %u", static_cast<unsigned>(LINEAR_BUFFER_MULTIPLIER));
+    benchReport(name, data.size(), saveSizes.size(), composerNs);
+}
+
+// Linear buffer growing from empty every iteration
+void benchBufferComposerGrowth()
+{
+    static constexpr size_t totalSize = 1024 * 1024;
+    std::vector<unsigned char> data(totalSize, 'x');
+    const std::vector<size_t> saveSizes = makeSaveSizes(SaveSizeDistribution::Uniform1To512, totalSize);
+
+    benchReport("vector append growth", totalSize, saveSizes.size(), benchVectorAppend(data, saveSizes, false));
+    benchBufferComposerGrowthWithMultiplier<2>(data, saveSizes);
+    benchBufferComposerGrowthWithMultiplier<4>(data, saveSizes);
+    benchBufferComposerGrowthWithMultiplier<8>(data, saveSizes);
+
+    using namespace restools;
+
+    buffer_composer<256, 2, 4096, std::allocator<unsigned char>, buffer_composer_no_statistics, page_rounded_growth<2>>
+        pageRoundedComposer(totalSize, totalSize);
+    benchReport("composer linear growth page rounded", totalSize, saveSizes.size(),
+        benchComposerSaveCompose(pageRoundedComposer, data, saveSizes, false));
+
+    // The heap recycles warm pages of a 1mb buffer, every mapping faults in fresh ones
+    buffer_composer<256, 2, 4096, remap_allocator<unsigned char, 64 * 1024>> remapComposer(totalSize, totalSize);
+    benchReport("composer linear growth remap_allocator", totalSize, saveSizes.size(),
+        benchComposerSaveCompose(remapComposer, data, saveSizes, false));
+
+    // Above the largest malloc mmap threshold (32mb) both map fresh pages, remapping saves the copies
+    static constexpr size_t hugeTotalSize = 64 * 1024 * 1024;
+    std::vector<unsigned char> hugeData(hugeTotalSize, 'x');
+    const std::vector<size_t> hugeSaveSizes = makeSaveSizes(SaveSizeDistribution::Uniform1To512, hugeTotalSize);
+
+    buffer_composer<256, 2, 4096> hugeComposer(hugeTotalSize, hugeTotalSize);
+    benchReport("composer linear growth multiplier 2 64mb", hugeTotalSize, hugeSaveSizes.size(),
+        benchComposerSaveCompose(hugeComposer, hugeData, hugeSaveSizes, false));
+
+    buffer_composer<256, 2, 4096, remap_allocator<unsigned char>> hugeRemapComposer(hugeTotalSize, hugeTotalSize);
+    benchReport("composer linear growth remap_allocator 64mb", hugeTotalSize, hugeSaveSizes.size(),
+        benchComposerSaveCompose(hugeRemapComposer, hugeData, hugeSaveSizes, false));
+}
+
+// CRC32C of the composed buffer in a second pass against the checksum fused into save()
+void benchBufferComposerChecksum()
+{
+    using namespace restools;
+
+    static constexpr size_t linearBufferMaxSize = 64 * 1024;
+
+    for (size_t totalSize : { size_t(48 * 1024), size_t(4 * 1024 * 1024) }) {
+        std::vector<unsigned char> data(totalSize, 'x');
+        const std::vector<size_t> saveSizes = makeSaveSizes(SaveSizeDistribution::Uniform1To512, totalSize);
+        char name[96];
+
+        buffer_composer<> composer(linearBufferMaxSize, totalSize);
+        double secondPassNs = benchMeasureNs(benchIterations(totalSize), [&]()
+        {
+            size_t offset = 0;
+            for (size_t saveSize : saveSizes) {
+                composer.save(data.data() + offset, saveSize);
+                offset += saveSize;
+            }
+            unsigned char* composedData = nullptr;
+            size_t composedDataSize = 0;
+            composer.compose(composedData, composedDataSize);
+            benchSink = crc32c(composedData, composedDataSize);
+            composer.clear();
+        });
+        std::snprintf(name, sizeof(name), "composer compose then crc32c %zuKB", totalSize / 1024);
+        benchReport(name, totalSize, saveSizes.size(), secondPassNs);
+
+        buffer_composer<256, 2, 4096, std::allocator<unsigned char>, buffer_composer_no_statistics, geometric_growth<2>,
+            crc32c_checksum> checksumComposer(linearBufferMaxSize, totalSize);
+        double fusedNs = benchMeasureNs(benchIterations(totalSize), [&]()
+        {
+            size_t offset = 0;
+            for (size_t saveSize : saveSizes) {
+                checksumComposer.save(data.data() + offset, saveSize);
+                offset += saveSize;
+            }
+            unsigned char* composedData = nullptr;
+            size_t composedDataSize = 0;
+            uint32_t checksum = 0;
+            checksumComposer.compose(composedData, composedDataSize, checksum);
+            benchSink = checksum;
+            checksumComposer.clear();
+        });
+        std::snprintf(name, sizeof(name), "composer crc32c fused into save %zuKB", totalSize / 1024);
+        benchReport(name, totalSize, saveSizes.size(), fusedNs);
+    }
+}
+
+// Flattening of chunks only, saves are not measured: one memcpy per chunk against copy_workers
+// with non-temporal stores
+void benchBufferComposerParallelCompose()
+{
+    using namespace restools;
+
+    static constexpr size_t totalSize = 256 * 1024 * 1024;
+    static constexpr size_t saveSize = 64 * 1024;
+    static constexpr size_t iterations = 4;
+    std::vector<unsigned char> data(totalSize, 'x');
+    const size_t threadsCount = std::max<size_t>(1, std::thread::hardware_concurrency()) - 1;
+    copy_workers workers(threadsCount);
+    char name[96];
+
+    auto measureCompose = [&](copy_workers* composeWorkers)
+    {
+        buffer_composer<> composer(4096, totalSize);
+        composer.enableParallelCompose(composeWorkers, 0);
+        double composeNs = 0;
+
+        for (size_t i = 0; i < iterations; ++i) {
+            for (size_t offset = 0; offset < totalSize; offset += saveSize) {
+                composer.save(data.data() + offset, saveSize);
+            }
+
+            unsigned char* composedData = nullptr;
+            size_t composedDataSize = 0;
+            const auto start = std::chrono::steady_clock::now();
+            composer.compose(composedData, composedDataSize);
+            composeNs += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+            benchSink = composedData[composedDataSize / 2];
+            composer.clear();
+        }
+
+        return composeNs / static_cast<double>(iterations);
+    };
+
+    benchReport("composer compose 256MB memcpy", totalSize, totalSize / saveSize, measureCompose(nullptr));
+    std::snprintf(name, sizeof(name), "composer compose 256MB streaming, %zu threads", workers.concurrency());
+    benchReport(name, totalSize, totalSize / saveSize, measureCompose(&workers));
+}
+
+// Pinned 4KB payloads behind 16 byte headers, gathered with composeSegments() as for writev():
+// copying every payload against referencing it
+void benchBufferComposerSaveRef()
+{
+    using namespace restools;
+
+    static constexpr size_t messagesCount = 256;
+    static constexpr size_t payloadSize = 4096;
+    static constexpr size_t headerSize = 16;
+    static constexpr size_t totalSize = messagesCount * (headerSize + payloadSize);
+    std::vector<unsigned char> payloads(messagesCount * payloadSize, 'p');
+    const unsigned char header[headerSize] = {};
+    std::vector<BufferComposerSegment> segments(2 * messagesCount + 1);
+
+    auto measure = [&](bool isReferenced)
+    {
+        buffer_composer<> composer(64 * 1024, totalSize);
+
+        return benchMeasureNs(benchIterations(totalSize), [&]()
+        {
+            for (size_t i = 0; i < messagesCount; ++i) {
+                composer.save(header, headerSize);
+                if (isReferenced) {
+                    composer.saveRef(payloads.data() + i * payloadSize, payloadSize);
+                }
+                else {
+                    composer.save(payloads.data() + i * payloadSize, payloadSize);
+                }
+            }
+            size_t segmentsCount = 0;
+            size_t composedDataSize = 0;
+            composer.composeSegments(segments.data(), segments.size(), segmentsCount, composedDataSize);
+            benchSink = segmentsCount;
+            composer.clear();
+        });
+    };
+
+    benchReport("composer save header+4KB payload segments", totalSize, messagesCount, measure(false));
+    benchReport("composer saveRef 4KB payload segments", totalSize, messagesCount, measure(true));
+}
+
+void benchBufferComposerIncrementalCompose()
+{
+    using namespace restools;
+
+    static constexpr size_t recordsCount = 1024;
+    static constexpr size_t recordSize = 256;
+    static constexpr size_t totalSize = recordsCount * recordSize;
+    std::vector<unsigned char> record(recordSize, 'r');
+
+    // an append-only log composed after every record, against composing once at the end
+    auto measure = [&](bool isComposedPerRecord)
+    {
+        buffer_composer<> composer(16 * 1024, totalSize);
+
+        return benchMeasureNs(benchIterations(totalSize), [&]()
+        {
+            unsigned char* composedData = nullptr;
+            size_t composedDataSize = 0;
+            for (size_t i = 0; i < recordsCount; ++i) {
+                composer.save(record.data(), recordSize);
+                if (isComposedPerRecord) {
+                    composer.compose(composedData, composedDataSize);
+                }
+            }
+            composer.compose(composedData, composedDataSize);
+            benchSink = composedData[composedDataSize - 1];
+            composer.clear();
+        });
+    };
+
+    benchReport("composer compose once per 256KB log", totalSize, recordsCount, measure(false));
+    benchReport("composer compose per 256B record", totalSize, recordsCount, measure(true));
+}
+
+void benchBufferComposer()
+{
+    benchBufferComposerTiers();
+    benchBufferComposerGrowth();
+    benchBufferComposerChunks();
+    benchBufferComposerChecksum();
+    benchBufferComposerParallelCompose();
+    benchBufferComposerSaveRef();
+    benchBufferComposerIncrementalCompose();
+}
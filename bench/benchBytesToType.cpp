@@ -0,0 +1,278 @@
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "restools/bit_stream.hpp"
+#include "restools/bytes_to_columns.hpp"
+#include "restools/bytes_to_type.hpp"
+#include "restools/bytes_to_type_array.hpp"
+#include "restools/varint.hpp"
+
+#include "bench.hpp"
+
+template <typename T>
+void benchBytesToTypeArrayForType(const char* typeName)
+{
+    using namespace restools;
+
+    static constexpr size_t count = 256 * 1024;
+    static constexpr size_t iterations = 64;
+    std::vector<unsigned char> srcBytes(count * sizeof(T));
+    for (size_t i = 0; i < srcBytes.size(); ++i) {
+        srcBytes[i] = static_cast<unsigned char>(i);
+    }
+    std::vector<T> dstValues(count);
+    char name[96];
+
+    double loopNs = benchMeasureNs(iterations, [&]()
+    {
+        for (size_t i = 0; i < count; ++i) {
+            bytesToTypeFast(srcBytes.data() + i * sizeof(T), dstValues[i], true);
+        }
+        benchSink = static_cast<size_t>(dstValues[count / 2]);
+    });
+    std::snprintf(name, sizeof(name), "bytesToTypeFast loop big endian %s", typeName);
+    benchReport(name, srcBytes.size(), count, loopNs);
+
+    double arrayNs = benchMeasureNs(iterations, [&]()
+    {
+        bytesToTypeArrayFast(srcBytes.data(), count, dstValues.data(), true);
+        benchSink = static_cast<size_t>(dstValues[count / 2]);
+    });
+    std::snprintf(name, sizeof(name), "bytesToTypeArrayFast big endian %s", typeName);
+    benchReport(name, srcBytes.size(), count, arrayNs);
+}
+
+void benchBytesToTypeArray()
+{
+    std::printf("ssse3: %d, avx2: %d\n", restools::cpuSupportsSsse3(), restools::cpuSupportsAvx2());
+
+    benchBytesToTypeArrayForType<uint16_t>("uint16_t");
+    benchBytesToTypeArrayForType<uint32_t>("uint32_t");
+    benchBytesToTypeArrayForType<uint64_t>("uint64_t");
+    benchBytesToTypeArrayForType<double>("double");
+}
+
+// Per-value safe conversions against hand written shifts, the usual code they replace
+template <typename T>
+void benchBytesToTypeSafeForType(const char* typeName)
+{
+    using namespace restools;
+
+    static constexpr size_t count = 256 * 1024;
+    static constexpr size_t iterations = 64;
+    std::vector<unsigned char> bytes(count * sizeof(T));
+    for (size_t i = 0; i < bytes.size(); ++i) {
+        bytes[i] = static_cast<unsigned char>(i);
+    }
+    std::vector<T> values(count);
+    char name[96];
+
+    double shiftsNs = benchMeasureNs(iterations, [&]()
+    {
+        for (size_t i = 0; i < count; ++i) {
+            const unsigned char* src = bytes.data() + i * sizeof(T);
+            T value = 0;
+            for (size_t byteIndex = 0; byteIndex < sizeof(T); ++byteIndex) {
+                value = static_cast<T>((value << 8) | src[byteIndex]);
+            }
+            values[i] = value;
+        }
+        benchSink = static_cast<size_t>(values[count / 2]);
+    });
+    std::snprintf(name, sizeof(name), "shifts read big endian %s", typeName);
+    benchReport(name, bytes.size(), count, shiftsNs);
+
+    double bytesToTypeNs = benchMeasureNs(iterations, [&]()
+    {
+        for (size_t i = 0; i < count; ++i) {
+            bytesToTypeSafe(bytes.data() + i * sizeof(T), sizeof(T), values[i], true);
+        }
+        benchSink = static_cast<size_t>(values[count / 2]);
+    });
+    std::snprintf(name, sizeof(name), "bytesToTypeSafe big endian %s", typeName);
+    benchReport(name, bytes.size(), count, bytesToTypeNs);
+
+    double typeToBytesNs = benchMeasureNs(iterations, [&]()
+    {
+        for (size_t i = 0; i < count; ++i) {
+            typeToBytesSafe(values[i], bytes.data() + i * sizeof(T), sizeof(T), true);
+        }
+        benchSink = bytes[bytes.size() / 2];
+    });
+    std::snprintf(name, sizeof(name), "typeToBytesSafe big endian %s", typeName);
+    benchReport(name, bytes.size(), count, typeToBytesNs);
+}
+
+void benchBytesToTypeSafe()
+{
+    benchBytesToTypeSafeForType<uint16_t>("uint16_t");
+    benchBytesToTypeSafeForType<uint32_t>("uint32_t");
+    benchBytesToTypeSafeForType<uint64_t>("uint64_t");
+}
+
+// Batched varint decoding against the usual byte-at-a-time loop, for values of up to maxBits bits
+void benchVarintForBits(unsigned maxBits)
+{
+    using namespace restools;
+
+    static constexpr size_t count = 256 * 1024;
+    static constexpr size_t iterations = 32;
+    std::mt19937_64 generator(3);
+    std::vector<uint64_t> values(count);
+    for (uint64_t& value : values) {
+        value = generator() >> (64 - 1 - generator() % maxBits);
+    }
+
+    std::vector<unsigned char> bytes(count * VARINT_MAX_SIZE<uint64_t>);
+    size_t bytesSize = 0;
+    varintToBytesArraySafe(values.data(), count, bytes.data(), bytes.size(), bytesSize);
+    std::vector<uint64_t> decodedValues(count);
+    char name[96];
+
+    double loopNs = benchMeasureNs(iterations, [&]()
+    {
+        size_t position = 0;
+        for (size_t i = 0; i < count; ++i) {
+            uint64_t value = 0;
+            unsigned shift = 0;
+            unsigned char byte = 0;
+            do {
+                byte = bytes[position++];
+                value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+                shift += 7;
+            } while (byte & 0x80);
+            decodedValues[i] = value;
+        }
+        benchSink = static_cast<size_t>(decodedValues[count / 2]);
+    });
+    std::snprintf(name, sizeof(name), "varint byte loop up to %u bits", maxBits);
+    benchReport(name, bytesSize, count, loopNs);
+
+    double batchNs = benchMeasureNs(iterations, [&]()
+    {
+        size_t readSize = 0;
+        bytesToVarintArraySafe(bytes.data(), bytesSize, decodedValues.data(), count, readSize);
+        benchSink = static_cast<size_t>(decodedValues[count / 2]);
+    });
+    std::snprintf(name, sizeof(name), "bytesToVarintArraySafe up to %u bits", maxBits);
+    benchReport(name, bytesSize, count, batchNs);
+}
+
+void benchVarint()
+{
+    benchVarintForBits(7);
+    benchVarintForBits(14);
+    benchVarintForBits(32);
+    benchVarintForBits(64);
+}
+
+// Records of 23 bytes split into 5 columns: field by field, record by record against bytesToColumnsFast
+void benchBytesToColumns()
+{
+    using namespace restools;
+
+    static constexpr size_t recordSize = 23;
+    static constexpr size_t count = 256 * 1024;
+    static constexpr size_t iterations = 32;
+    std::vector<unsigned char> records(count * recordSize);
+    for (size_t i = 0; i < records.size(); ++i) {
+        records[i] = static_cast<unsigned char>(i * 7);
+    }
+
+    std::vector<uint64_t> ids(count);
+    std::vector<double> prices(count);
+    std::vector<int32_t> quantities(count);
+    std::vector<uint16_t> flags(count);
+    std::vector<uint8_t> kinds(count);
+
+    double loopNs = benchMeasureNs(iterations, [&]()
+    {
+        for (size_t i = 0; i < count; ++i) {
+            const unsigned char* record = records.data() + i * recordSize;
+            bytesToTypeFast<std::endian::big>(record, ids[i]);
+            bytesToTypeFast<std::endian::little>(record + 8, prices[i]);
+            bytesToTypeFast<std::endian::big>(record + 16, quantities[i]);
+            bytesToTypeFast<std::endian::little>(record + 20, flags[i]);
+            kinds[i] = record[22];
+        }
+        benchSink = static_cast<size_t>(ids[count / 2] + kinds[count / 3]);
+    });
+    benchReport("bytesToTypeFast per field 5 columns", records.size(), count, loopNs);
+
+    const record_column columns[] = {
+        record_column(0, ids.data(), true),
+        record_column(8, prices.data(), false),
+        record_column(16, quantities.data(), true),
+        record_column(20, flags.data(), false),
+        record_column(22, kinds.data(), false),
+    };
+
+    double columnsNs = benchMeasureNs(iterations, [&]()
+    {
+        bytesToColumnsFast(records.data(), records.size(), recordSize, count, columns, std::size(columns));
+        benchSink = static_cast<size_t>(ids[count / 2] + kinds[count / 3]);
+    });
+    benchReport("bytesToColumnsFast 5 columns", records.size(), count, columnsNs);
+}
+
+// 13-bit MSB-first fields: shifts over a 4 byte bytesToTypeFast load per field against bit_reader
+void benchBitReader()
+{
+    using namespace restools;
+
+    static constexpr size_t count = 1024 * 1024;
+    static constexpr size_t bitsCount = 13;
+    static constexpr size_t iterations = 16;
+    // the per-field load reads up to 3 bytes past the last field
+    std::vector<unsigned char> bytes((count * bitsCount + 7) / 8 + 4);
+    bit_writer<BitOrder::MsbFirst> writer(bytes.data(), bytes.size());
+    for (size_t i = 0; i < count; ++i) {
+        writer.writeFast(bitsCount, i * 2654435761u);
+    }
+    writer.flush();
+    std::vector<uint16_t> values(count);
+
+    double shiftsNs = benchMeasureNs(iterations, [&]()
+    {
+        for (size_t i = 0; i < count; ++i) {
+            const size_t bitPosition = i * bitsCount;
+            uint32_t word = 0;
+            bytesToTypeFast<std::endian::big>(bytes.data() + bitPosition / 8, word);
+            values[i] = static_cast<uint16_t>((word >> (32 - bitsCount - bitPosition % 8)) & ((1u << bitsCount) - 1));
+        }
+        benchSink = values[count / 2];
+    });
+    benchReport("bytesToTypeFast and shifts 13-bit fields", bytes.size(), count, shiftsNs);
+
+    double readerNs = benchMeasureNs(iterations, [&]()
+    {
+        bit_reader<BitOrder::MsbFirst> reader(bytes.data(), bytes.size());
+        for (size_t i = 0; i < count; ++i) {
+            values[i] = static_cast<uint16_t>(reader.readFast(bitsCount));
+        }
+        benchSink = values[count / 2];
+    });
+    benchReport("bit_reader readFast 13-bit fields", bytes.size(), count, readerNs);
+
+    double writerNs = benchMeasureNs(iterations, [&]()
+    {
+        bit_writer<BitOrder::MsbFirst> benchWriter(bytes.data(), bytes.size());
+        for (size_t i = 0; i < count; ++i) {
+            benchWriter.writeFast(bitsCount, values[i]);
+        }
+        benchWriter.flush();
+        benchSink = bytes[bytes.size() / 2];
+    });
+    benchReport("bit_writer writeFast 13-bit fields", bytes.size(), count, writerNs);
+}
+
+void benchBytesToType()
+{
+    benchBytesToTypeSafe();
+    benchVarint();
+    benchBytesToTypeArray();
+    benchBytesToColumns();
+    benchBitReader();
+}
@@ -0,0 +1,8 @@
+extern void benchBufferComposer();
+extern void benchBytesToType();
+
+int main()
+{
+    benchBufferComposer();
+    benchBytesToType();
+}
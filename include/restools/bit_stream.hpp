@@ -0,0 +1,405 @@
+#pragma once
+
+#include <bit> // endian
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#include "restools/bytes_to_type.hpp"
+
+namespace restools
+{
+    // Order of bits inside a byte: MsbFirst is the network order of most bit-packed protocols,
+    // LsbFirst is the order of deflate and of most little endian hardware formats
+    enum class BitOrder : short
+    {
+        MsbFirst,
+        LsbFirst,
+    };
+
+    enum class BitReaderStatus : short
+    {
+        Success,
+        BufferIsOverflow,
+        BitsCountIsOverType,
+    };
+
+    enum class BitWriterStatus : short
+    {
+        Success,
+        BufferIsOverflow,
+        BitsCountIsOverType,
+        ValueIsOverBitsCount,
+    };
+
+    namespace detail
+    {
+        template <typename T, bool = std::is_enum_v<T>>
+        struct BitFieldIntegralOf
+        {
+            using type = T;
+        };
+
+        template <typename T>
+        struct BitFieldIntegralOf<T, true>
+        {
+            using type = std::underlying_type_t<T>;
+        };
+
+        template <typename T>
+        using BitFieldIntegral = typename BitFieldIntegralOf<T>::type;
+
+        template <typename T>
+        inline constexpr bool isBitFieldType = (std::is_integral_v<T> || std::is_enum_v<T>) && sizeof(T) <= 8;
+
+        // Low bitsCount bits of value, bitsCount in [0, 64]
+        template <typename T>
+        constexpr uint64_t toBitField(T value, size_t bitsCount) noexcept
+        {
+            using I = BitFieldIntegral<T>;
+            uint64_t bits = 0;
+
+            if constexpr (std::is_same_v<I, bool>) {
+                bits = value ? 1 : 0;
+            }
+            else {
+                bits = static_cast<uint64_t>(static_cast<std::make_unsigned_t<I>>(value));
+            }
+
+            return bitsCount == 64 ? bits : bits & ((uint64_t(1) << bitsCount) - 1);
+        }
+    }
+
+    // Cursor decoding fields of 0 to 64 bits from a byte span. Bits are kept in a 64-bit accumulator which
+    // is refilled with one unaligned 8 byte load while 8 bytes remain and byte by byte at the end.
+    // Signed fields are sign extended from their bit count.
+    template <BitOrder ORDER>
+    class bit_reader
+    {
+    public:
+        bit_reader(const unsigned char* data, size_t size) noexcept
+            : data_(data)
+            , size_(size)
+        {
+        }
+
+        // Reads bitsCount bits which must remain, bitsCount in [0, 64]
+        uint64_t readFast(size_t bitsCount) noexcept
+        {
+            if (bitsCount > FETCH_BITS_MAX) {
+                const size_t lowBitsCount = bitsCount - FETCH_BITS_MAX;
+
+                if constexpr (ORDER == BitOrder::MsbFirst) {
+                    const uint64_t high = fetch(FETCH_BITS_MAX);
+                    return (high << lowBitsCount) | fetch(lowBitsCount);
+                }
+                else {
+                    const uint64_t low = fetch(FETCH_BITS_MAX);
+                    return low | (fetch(lowBitsCount) << FETCH_BITS_MAX);
+                }
+            }
+
+            return fetch(bitsCount);
+        }
+
+        template <typename T>
+        BitReaderStatus read(size_t bitsCount, T& value) noexcept
+        {
+            static_assert(detail::isBitFieldType<T>, "T is not integral or enum");
+
+            if (bitsCount > (std::is_same_v<T, bool> ? 1 : sizeof(T) * 8)) {
+                return BitReaderStatus::BitsCountIsOverType;
+            }
+
+            if (bitsCount > remainingBits()) {
+                return BitReaderStatus::BufferIsOverflow;
+            }
+
+            using I = detail::BitFieldIntegral<T>;
+            uint64_t bits = readFast(bitsCount);
+
+            if constexpr (std::is_signed_v<I>) {
+                if (bitsCount > 0 && bitsCount < 64 && (bits >> (bitsCount - 1)) != 0) {
+                    bits |= ~uint64_t(0) << bitsCount;
+                }
+            }
+
+            value = static_cast<T>(static_cast<I>(bits));
+
+            return BitReaderStatus::Success;
+        }
+
+        BitReaderStatus skip(size_t bitsCount) noexcept
+        {
+            if (bitsCount > remainingBits()) {
+                return BitReaderStatus::BufferIsOverflow;
+            }
+
+            for (; bitsCount > 64; bitsCount -= 64) {
+                readFast(64);
+            }
+            readFast(bitsCount);
+
+            return BitReaderStatus::Success;
+        }
+
+        // Skips the bits left in the current byte
+        void alignToByte() noexcept
+        {
+            readFast((8 - bitPosition() % 8) % 8);
+        }
+
+        size_t bitPosition() const noexcept
+        {
+            return bytePosition_ * 8 - bitsCount_;
+        }
+
+        size_t remainingBits() const noexcept
+        {
+            return (size_ - bytePosition_) * 8 + bitsCount_;
+        }
+
+    private:
+        // A refill leaves at least 56 bits when they remain
+        static constexpr size_t FETCH_BITS_MAX = 56;
+
+        // MsbFirst keeps the next bit in the highest bit of the accumulator, LsbFirst in the lowest.
+        // Bits past bitsCount_ are the following bytes as loaded, a later refill ORs the same bits again.
+        void refill() noexcept
+        {
+            // Bounded by size_ alone first, so the compiler sees no 8-byte load from a shorter buffer
+            if (size_ >= sizeof(uint64_t) && bytePosition_ <= size_ - sizeof(uint64_t)) {
+                uint64_t loaded = 0;
+
+                if constexpr (ORDER == BitOrder::MsbFirst) {
+                    bytesToTypeFast<std::endian::big>(data_ + bytePosition_, loaded);
+                    accumulator_ |= loaded >> bitsCount_;
+                }
+                else {
+                    bytesToTypeFast<std::endian::little>(data_ + bytePosition_, loaded);
+                    accumulator_ |= loaded << bitsCount_;
+                }
+
+                bytePosition_ += (63 - bitsCount_) >> 3;
+                bitsCount_ |= 56;
+                return;
+            }
+
+            for (; bitsCount_ <= 56 && bytePosition_ < size_; ++bytePosition_, bitsCount_ += 8) {
+                if constexpr (ORDER == BitOrder::MsbFirst) {
+                    accumulator_ |= static_cast<uint64_t>(data_[bytePosition_]) << (56 - bitsCount_);
+                }
+                else {
+                    accumulator_ |= static_cast<uint64_t>(data_[bytePosition_]) << bitsCount_;
+                }
+            }
+        }
+
+        uint64_t fetch(size_t bitsCount) noexcept
+        {
+            if (bitsCount_ < bitsCount) {
+                refill();
+            }
+
+            if (bitsCount == 0) {
+                return 0;
+            }
+
+            uint64_t bits = 0;
+
+            if constexpr (ORDER == BitOrder::MsbFirst) {
+                bits = accumulator_ >> (64 - bitsCount);
+                accumulator_ <<= bitsCount;
+            }
+            else {
+                bits = accumulator_ & ((uint64_t(1) << bitsCount) - 1);
+                accumulator_ >>= bitsCount;
+            }
+
+            bitsCount_ -= bitsCount;
+
+            return bits;
+        }
+
+        const unsigned char* data_;
+        size_t size_;
+        size_t bytePosition_ = 0;
+        uint64_t accumulator_ = 0;
+        size_t bitsCount_ = 0;
+    };
+
+    // Cursor encoding fields of 0 to 64 bits into a byte span. Bits are collected in a 64-bit accumulator and
+    // whole bytes of it are stored with one unaligned 8 byte store while 8 bytes of capacity remain.
+    // Bytes past writtenSize() may be overwritten. flush() stores the last partial byte, padded with zeros;
+    // writing can go on after it.
+    template <BitOrder ORDER>
+    class bit_writer
+    {
+    public:
+        bit_writer(unsigned char* data, size_t capacity) noexcept
+            : data_(data)
+            , capacity_(capacity)
+        {
+        }
+
+        // Writes the low bitsCount bits of bits which must fit the capacity, bitsCount in [0, 64]
+        void writeFast(size_t bitsCount, uint64_t bits) noexcept
+        {
+            if (bitsCount > PUT_BITS_MAX) {
+                const size_t highBitsCount = bitsCount - PUT_BITS_MAX;
+
+                if constexpr (ORDER == BitOrder::MsbFirst) {
+                    put(highBitsCount, bits >> PUT_BITS_MAX);
+                    put(PUT_BITS_MAX, bits);
+                }
+                else {
+                    put(PUT_BITS_MAX, bits);
+                    put(highBitsCount, bits >> PUT_BITS_MAX);
+                }
+                return;
+            }
+
+            put(bitsCount, bits);
+        }
+
+        // A signed value must be representable in bitsCount bits two's complement
+        template <typename T>
+        BitWriterStatus write(size_t bitsCount, T value) noexcept
+        {
+            static_assert(detail::isBitFieldType<T>, "T is not integral or enum");
+
+            if (bitsCount > (std::is_same_v<T, bool> ? 1 : sizeof(T) * 8)) {
+                return BitWriterStatus::BitsCountIsOverType;
+            }
+
+            using I = detail::BitFieldIntegral<T>;
+            const I integral = static_cast<I>(value);
+
+            if (bitsCount < sizeof(I) * 8) {
+                if constexpr (std::is_signed_v<I>) {
+                    const int64_t limit = bitsCount == 0 ? 0 : int64_t(1) << (bitsCount - 1);
+                    if (integral < -limit || integral >= (bitsCount == 0 ? 1 : limit)) {
+                        return BitWriterStatus::ValueIsOverBitsCount;
+                    }
+                }
+                else if (static_cast<uint64_t>(integral) >> bitsCount != 0) {
+                    return BitWriterStatus::ValueIsOverBitsCount;
+                }
+            }
+
+            if (bitsCount > capacity_ * 8 - bitPosition()) {
+                return BitWriterStatus::BufferIsOverflow;
+            }
+
+            writeFast(bitsCount, detail::toBitField(value, bitsCount));
+
+            return BitWriterStatus::Success;
+        }
+
+        // Pads the current byte with zeros up to the next byte boundary, which must fit the capacity
+        void alignToByte() noexcept
+        {
+            writeFast((8 - bitPosition() % 8) % 8, 0);
+        }
+
+        void flush() noexcept
+        {
+            storeBytes();
+
+            if (bitsCount_ > 0) {
+                if constexpr (ORDER == BitOrder::MsbFirst) {
+                    data_[bytePosition_] = static_cast<unsigned char>(accumulator_ >> 56);
+                }
+                else {
+                    data_[bytePosition_] = static_cast<unsigned char>(accumulator_);
+                }
+            }
+        }
+
+        size_t bitPosition() const noexcept
+        {
+            return bytePosition_ * 8 + bitsCount_;
+        }
+
+        // Bytes holding the written bits, including a partial one
+        size_t writtenSize() const noexcept
+        {
+            return bytePosition_ + (bitsCount_ + 7) / 8;
+        }
+
+        size_t capacity() const noexcept
+        {
+            return capacity_;
+        }
+
+    private:
+        // The accumulator has at most 7 bits after storeBytes()
+        static constexpr size_t PUT_BITS_MAX = 57;
+
+        // MsbFirst collects bits from the highest bit of the accumulator down, LsbFirst from the lowest up
+        void storeBytes() noexcept
+        {
+            const size_t bytesCount = bitsCount_ / 8;
+
+            if (capacity_ - bytePosition_ >= 8) {
+                if constexpr (ORDER == BitOrder::MsbFirst) {
+                    typeToBytesFast<std::endian::big>(accumulator_, data_ + bytePosition_);
+                }
+                else {
+                    typeToBytesFast<std::endian::little>(accumulator_, data_ + bytePosition_);
+                }
+            }
+            else {
+                for (size_t i = 0; i < bytesCount; ++i) {
+                    if constexpr (ORDER == BitOrder::MsbFirst) {
+                        data_[bytePosition_ + i] = static_cast<unsigned char>(accumulator_ >> (56 - 8 * i));
+                    }
+                    else {
+                        data_[bytePosition_ + i] = static_cast<unsigned char>(accumulator_ >> (8 * i));
+                    }
+                }
+            }
+
+            if (bytesCount == 8) {
+                accumulator_ = 0;
+            }
+            else if constexpr (ORDER == BitOrder::MsbFirst) {
+                accumulator_ <<= 8 * bytesCount;
+            }
+            else {
+                accumulator_ >>= 8 * bytesCount;
+            }
+
+            bytePosition_ += bytesCount;
+            bitsCount_ -= 8 * bytesCount;
+        }
+
+        void put(size_t bitsCount, uint64_t bits) noexcept
+        {
+            if (bitsCount == 0) {
+                return;
+            }
+
+            if (bitsCount_ + bitsCount > 64) {
+                storeBytes();
+            }
+
+            bits &= ~uint64_t(0) >> (64 - bitsCount);
+
+            if constexpr (ORDER == BitOrder::MsbFirst) {
+                accumulator_ |= bits << (64 - bitsCount_ - bitsCount);
+            }
+            else {
+                accumulator_ |= bits << bitsCount_;
+            }
+
+            bitsCount_ += bitsCount;
+        }
+
+        unsigned char* data_;
+        size_t capacity_;
+        size_t bytePosition_ = 0;
+        uint64_t accumulator_ = 0;
+        size_t bitsCount_ = 0;
+    };
+}
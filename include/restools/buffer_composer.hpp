@@ -1,7 +1,22 @@
 #pragma once  
 
+#include <algorithm>
+#include <concepts>
 #include <cstring>
-#include <list>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "restools/buffer_composer_checksum.hpp"
+#include "restools/buffer_composer_statistics.hpp"
+#include "restools/copy_workers.hpp"
+#include "restools/growth_policy.hpp"
+#include "restools/mapped_buffer.hpp"
 
 namespace restools
 {
@@ -13,6 +28,10 @@ namespace restools
         MaxSavedBufferCountLimited,
         NotClearedAfterCompose,
         BufferIsOverlapping,
+        NotCommittedAfterReserve,
+        CommitIsOverReserved,
+        SpillIsFailed,
+        MemoryBudgetIsExceeded,
     };
 
     enum class BufferComposerComposeStatus : short
@@ -23,207 +42,1393 @@ namespace restools
         LogicErrorWhenComposingFromBuffer,
         LogicErrorWhenComposingFromChunks,
         ComposedDataFromChunksDontMatchToSavedCount,
+        SegmentsCapacityIsNotEnough,
+        MemoryBudgetIsExceeded,
+        NotCommittedAfterReserve,
+    };
+
+    enum class BufferComposerConsumeStatus : short
+    {
+        Success,
+        NotClearedAfterCompose,
+        NotCommittedAfterReserve,
+        ConsumedSizeIsOverSaved,
+    };
+
+    // Layout-compatible with POSIX iovec and WSABUF-style (pointer, length) pairs
+    struct BufferComposerSegment
+    {
+        const unsigned char* data = nullptr;
+        size_t size = 0;
     };
 
-    template <size_t STACK_BUFFER_MAX = 255 /*255b*/,
-        uint16_t LINEAR_BUFFER_MULTIPLIER = 2>
+    // Owns a buffer released by buffer_composer::release() and returns it to ALLOCATOR when destroyed,
+    // unless it is handed back to a composer with buffer_composer::adopt()
+    template <typename ALLOCATOR = std::allocator<unsigned char>>
+    class composed_buffer
+    {
+        using AllocatorTraits = std::allocator_traits<ALLOCATOR>;
+
+    public:
+        using allocator_type = ALLOCATOR;
+
+        composed_buffer() noexcept = default;
+
+        composed_buffer(unsigned char* data, size_t size, size_t capacity, const ALLOCATOR& allocator) noexcept
+            : data_(data)
+            , size_(size)
+            , capacity_(capacity)
+            , allocator_(allocator)
+        {
+        }
+
+        composed_buffer(const composed_buffer&) = delete;
+        composed_buffer(composed_buffer&& source) noexcept
+        {
+            *this = std::move(source);
+        }
+
+        ~composed_buffer()
+        {
+            reset();
+        }
+
+        composed_buffer& operator=(const composed_buffer&) = delete;
+        composed_buffer& operator=(composed_buffer&& source) noexcept
+        {
+            if (this != &source) {
+                reset();
+                data_ = std::exchange(source.data_, nullptr);
+                size_ = std::exchange(source.size_, 0);
+                capacity_ = std::exchange(source.capacity_, 0);
+                if (source.allocator_) {
+                    // emplace instead of assignment, std::pmr::polymorphic_allocator is not assignable
+                    allocator_.emplace(*source.allocator_);
+                }
+            }
+            return *this;
+        }
+
+        void reset() noexcept
+        {
+            if (data_) {
+                AllocatorTraits::deallocate(*allocator_, data_, capacity_);
+            }
+
+            data_ = nullptr;
+            size_ = 0;
+            capacity_ = 0;
+        }
+
+        unsigned char* release() noexcept
+        {
+            size_ = 0;
+            capacity_ = 0;
+            return std::exchange(data_, nullptr);
+        }
+
+        unsigned char* data() const noexcept
+        {
+            return data_;
+        }
+
+        size_t size() const noexcept
+        {
+            return size_;
+        }
+
+        size_t capacity() const noexcept
+        {
+            return capacity_;
+        }
+
+        bool empty() const noexcept
+        {
+            return size_ == 0;
+        }
+
+        allocator_type get_allocator() const noexcept
+        {
+            return allocator_ ? *allocator_ : ALLOCATOR();
+        }
+
+    private:
+        unsigned char* data_ = nullptr;
+        size_t size_ = 0;
+        size_t capacity_ = 0;
+        std::optional<ALLOCATOR> allocator_;
+    };
+
+    // Past the linear buffer, saved data is packed into chunks made of CHUNK_BLOCK_SIZE cache-aligned blocks.
+    // A save that does not fit the free tail of the last chunk opens a new chunk, so small saves
+    // share one allocation and the chunk index is a contiguous vector.
+    // saveRef() puts a reference to a caller's buffer into the chunk index instead of copying it,
+    // its bytes are copied only when compose() needs one contiguous buffer.
+    // ALLOCATOR serves the data of the composer: linear buffer, chunks, chunk index
+    // and the buffer composed from chunks. When it is backed by an arena which is reset between requests,
+    // call cleanup() before the reset, clear() keeps the linear buffer for reuse.
+    // Saving can go on after compose(): the buffer composed from chunks becomes the linear buffer, later saves
+    // fill its free tail and then chunks, and the next compose() copies only those chunks after it.
+    // With enableSpill(), saved data above the spill threshold moves into a file mapping (see mapped_buffer)
+    // and compose() returns a view of it, so a huge composition is never held twice on the heap.
+    // With enableParallelCompose(), a compose() copying at least the threshold from chunks is run by
+    // copy_workers, every thread copies its own range of the output with non-temporal stores.
+    // Settings of both live in one block allocated on the heap by the first enable call, a composer which
+    // never enables them only pays for a null pointer.
+    // STATISTICS receives allocations, copies per tier, tier transitions and save sizes,
+    // use buffer_composer_statistics to count them. The default one compiles to nothing.
+    // An allocation failure of ALLOCATOR (std::bad_alloc), e.g. over the budget of composer_slab, is returned
+    // as MemoryBudgetIsExceeded by save(), reserve() and compose(), the composer stays as it was before the call.
+    // GROWTH_POLICY sizes the linear buffer (see growth_policy.hpp). Regrowth moves saved bytes only, and
+    // an ALLOCATOR with reallocate(data, count, liveBegin, liveEnd, nextCount), e.g. remap_allocator, grows it in place.
+    // CHECKSUM copies saved bytes into the tiers, crc32c_checksum computes the checksum of everything saved
+    // since clear() in that same copy, so compose() gets the digest without another pass.
+    template <size_t STACK_BUFFER_MAX = 256 /*256b*/,
+        uint16_t LINEAR_BUFFER_MULTIPLIER = 2,
+        size_t CHUNK_BLOCK_SIZE = 4096 /*4kb*/,
+        typename ALLOCATOR = std::allocator<unsigned char>,
+        typename STATISTICS = buffer_composer_no_statistics,
+        typename GROWTH_POLICY = geometric_growth<LINEAR_BUFFER_MULTIPLIER>,
+        typename CHECKSUM = buffer_composer_no_checksum>
     class buffer_composer
     {
+        static constexpr size_t CHUNK_ALIGNMENT = 64;
+
         static_assert(STACK_BUFFER_MAX > 0 && STACK_BUFFER_MAX % 8 == 0, "STACK_BUFFER_MAX is not divisible to 8");
         static_assert(LINEAR_BUFFER_MULTIPLIER > 1, "LINEAR_BUFFER_MULTIPLIER < 2");
-        static constexpr size_t COMPOSED_BUFFER_IS_NOT_RESET_FLAG = 0xFFFFFFFFFFFFFFFF;
+        static_assert(CHUNK_BLOCK_SIZE > 0 && CHUNK_BLOCK_SIZE % CHUNK_ALIGNMENT == 0, "CHUNK_BLOCK_SIZE is not divisible to cache line");
+        static_assert(std::is_same_v<typename std::allocator_traits<ALLOCATOR>::pointer, unsigned char*>,
+            "ALLOCATOR must allocate unsigned char");
+
+        // A chunk of capacity 0 references a buffer of saveRef(), it is neither written nor freed
+        struct Chunk
+        {
+            unsigned char* data;
+            size_t size;
+            size_t capacity;
+        };
+
+        // Settings of enableSpill() and enableParallelCompose(), most composers never use them
+        struct Extensions
+        {
+            size_t spillThreshold = 0;
+            mapped_buffer spillBuffer;
+            copy_workers* composeWorkers = nullptr;
+            size_t parallelComposeThreshold = 0;
+        };
+
+        struct alignas(CHUNK_ALIGNMENT) ChunkLine
+        {
+            unsigned char bytes[CHUNK_ALIGNMENT];
+        };
+
+        using AllocatorTraits = std::allocator_traits<ALLOCATOR>;
+        static constexpr bool IS_ALLOCATOR_REALLOCATING = requires(ALLOCATOR& allocator, unsigned char* data, size_t count)
+        {
+            { allocator.reallocate(data, count, count, count, count) } -> std::same_as<unsigned char*>;
+        };
+        using ChunkAllocator = typename AllocatorTraits::template rebind_alloc<Chunk>;
+        using ChunkLineAllocator = typename AllocatorTraits::template rebind_alloc<ChunkLine>;
 
     public:
-        buffer_composer(size_t linearBufferMaxSize, size_t saveBufferMaxCount)
+        using allocator_type = ALLOCATOR;
+        using buffer_type = composed_buffer<ALLOCATOR>;
+        using statistics_type = STATISTICS;
+        using checksum_type = typename CHECKSUM::value_type;
+
+        buffer_composer(size_t linearBufferMaxSize, size_t saveBufferMaxCount, const ALLOCATOR& allocator = ALLOCATOR())
             : linearBufferMaxSize_(linearBufferMaxSize)
             , saveBufferMaxCount_(saveBufferMaxCount)
+            , chunks_(ChunkAllocator(allocator))
+            , allocator_(allocator)
         {
             stackBuffer_[0] = 0;
         }
 
         buffer_composer(const buffer_composer& rv) = delete;
-        buffer_composer(buffer_composer&&) = delete;
+
+        // A span returned by reserve() and not committed yet does not survive the move
+        buffer_composer(buffer_composer&& source) noexcept
+            : linearBufferMaxSize_(source.linearBufferMaxSize_)
+            , saveBufferMaxCount_(source.saveBufferMaxCount_)
+            , chunks_(std::move(source.chunks_))
+            , allocator_(source.allocator_)
+        {
+            moveStorageFrom(source);
+        }
+
         ~buffer_composer()
         {
             cleanup();
         }
 
         buffer_composer& operator=(const buffer_composer& source) = delete;
-        buffer_composer& operator=(buffer_composer&& source) = delete;
 
-        BufferComposerSaveStatus save(const unsigned char* buffer, size_t bufferSize) noexcept
+        // Storage is stolen when allocators are equal or propagate on move, otherwise data is copied
+        // into the storage of this allocator. Either way settings, statistics and checksum come from the source.
+        // When that copy fails this composer is left empty, the source keeps its data and std::bad_alloc is thrown.
+        buffer_composer& operator=(buffer_composer&& source) noexcept(
+            AllocatorTraits::propagate_on_container_move_assignment::value || AllocatorTraits::is_always_equal::value)
         {
-            if (savedCount_ == COMPOSED_BUFFER_IS_NOT_RESET_FLAG) {
-                return BufferComposerSaveStatus::NotClearedAfterCompose;
+            if (this == &source) {
+                return *this;
             }
 
-            if (!buffer) {
-                return BufferComposerSaveStatus::NullBuffer;
+            cleanup();
+            linearBufferMaxSize_ = source.linearBufferMaxSize_;
+            saveBufferMaxCount_ = source.saveBufferMaxCount_;
+
+            if constexpr (AllocatorTraits::propagate_on_container_move_assignment::value) {
+                allocator_ = source.allocator_;
+            }
+            else if (allocator_ != source.allocator_) {
+                extensions_.reset();
+                if (source.extensions_) {
+                    const Extensions& settings = *source.extensions_;
+                    extensions_ = std::make_unique<Extensions>(Extensions{ settings.spillThreshold,
+                        mapped_buffer(settings.spillBuffer.directory()), settings.composeWorkers, settings.parallelComposeThreshold });
+                }
+                if (!copyDataFrom(source)) {
+                    cleanup();
+                    extensions_.reset();
+                    throw std::bad_alloc();
+                }
+                checksum_ = std::exchange(source.checksum_, CHECKSUM());
+                source.cleanup();
+                source.extensions_.reset();
+                statistics_ = std::exchange(source.statistics_, STATISTICS());
+                reportStorage();
+                return *this;
             }
 
-            if (bufferSize == 0) {
-                return BufferComposerSaveStatus::ZeroBufferSize;
+            chunks_ = std::move(source.chunks_);
+            moveStorageFrom(source);
+
+            return *this;
+        }
+
+        BufferComposerSaveStatus save(const unsigned char* buffer, size_t bufferSize) noexcept
+        {
+            const BufferComposerSaveStatus status = checkSave(buffer, bufferSize);
+
+            if (status != BufferComposerSaveStatus::Success) {
+                return status;
             }
 
             const size_t nextSavedCount = savedCount_ + bufferSize;
 
-            if (nextSavedCount > saveBufferMaxCount_) {
-                return BufferComposerSaveStatus::MaxSavedBufferCountLimited;
+            try {
+                if (isSpilling(bufferSize)) {
+                    unsigned char* spillBuffer = reserveInSpill(bufferSize);
+                    if (!spillBuffer) {
+                        return BufferComposerSaveStatus::SpillIsFailed;
+                    }
+                    checksum_.copy(spillBuffer, buffer, bufferSize);
+                }
+                else if (unsigned char* inBuffer = reserveInBuffer(nextSavedCount)) {
+                    checksum_.copy(inBuffer + inBufferSavedCount_, buffer, bufferSize);
+                    inBufferSavedCount_ = nextSavedCount;
+                }
+                else {
+                    saveToChunks(buffer, bufferSize);
+                }
+            }
+            catch (const std::bad_alloc&) {
+                return BufferComposerSaveStatus::MemoryBudgetIsExceeded;
             }
 
-            if (nextSavedCount <= STACK_BUFFER_MAX) {
-                if (buffer >= stackBuffer_ && buffer <= (stackBuffer_ + STACK_BUFFER_MAX)) {
-                    return BufferComposerSaveStatus::BufferIsOverlapping;
-                }
+            statistics_.onSave(bufferSize);
+            statistics_.onCopy(currentTier(), bufferSize);
+            savedCount_ += bufferSize;
 
-                std::memcpy(stackBuffer_ + savedCount_, buffer, bufferSize);
-                savedCount_ = nextSavedCount;
-                inBufferSavedCount_ = nextSavedCount;
-                return BufferComposerSaveStatus::Success;
+            return BufferComposerSaveStatus::Success;
+        }
+
+        // Saves a reference to buffer instead of a copy: the buffer must stay valid and unchanged until its bytes
+        // are consumed or the composer is cleared. It is copied only by compose(), release() or a move into
+        // the spill; composeSegments() and forEachSegment() return it as is. References and copies can be mixed,
+        // a save() after a reference goes to a new chunk, so short buffers are usually cheaper to save().
+        // With spilling enabled the buffer is copied into the spill as by save().
+        BufferComposerSaveStatus saveRef(const unsigned char* buffer, size_t bufferSize) noexcept
+        {
+            const BufferComposerSaveStatus status = checkSave(buffer, bufferSize);
+
+            if (status != BufferComposerSaveStatus::Success) {
+                return status;
+            }
+
+            if (isSpilling(bufferSize)) {
+                return save(buffer, bufferSize);
+            }
+
+            try {
+                growChunksIndex();
+            }
+            catch (const std::bad_alloc&) {
+                return BufferComposerSaveStatus::MemoryBudgetIsExceeded;
+            }
+
+            if (chunks_.empty()) {
+                statistics_.onTransition(currentTier(), BufferComposerTier::Chunks);
+            }
+
+            chunks_.push_back({ const_cast<unsigned char*>(buffer), bufferSize, 0 });
+            checksum_.update(buffer, bufferSize);
+            statistics_.onSave(bufferSize);
+            savedCount_ += bufferSize;
+
+            return BufferComposerSaveStatus::Success;
+        }
+
+        // Returns a writable span of reserveSize bytes in the current tier, e.g. for recv()/read() to fill directly.
+        // The span stays valid until commit(), which saves the first committedSize bytes of it.
+        BufferComposerSaveStatus reserve(size_t reserveSize, unsigned char*& reservedBuffer) noexcept
+        {
+            if (reservedSize_ > 0) {
+                return BufferComposerSaveStatus::NotCommittedAfterReserve;
+            }
+
+            if (reserveSize == 0) {
+                return BufferComposerSaveStatus::ZeroBufferSize;
             }
 
-            if (nextSavedCount <= linearBufferMaxSize_) {
-                if (!linearBuffer_) {
-                    size_t allocatedSize = std::min(linearBufferMaxSize_, nextSavedCount * LINEAR_BUFFER_MULTIPLIER);
-                    linearBuffer_ = new unsigned char[allocatedSize];
-                    linearBufferAllocatedSize_ = allocatedSize;
+            const size_t nextSavedCount = savedCount_ + reserveSize;
+
+            if (savedCount() + reserveSize > saveBufferMaxCount_) {
+                return BufferComposerSaveStatus::MaxSavedBufferCountLimited;
+            }
+
+            try {
+                if (isSpilling(reserveSize)) {
+                    reservedBuffer = reserveInSpill(reserveSize);
+                    if (!reservedBuffer) {
+                        return BufferComposerSaveStatus::SpillIsFailed;
+                    }
                 }
-                else if (nextSavedCount > linearBufferAllocatedSize_) {
-                    size_t allocatedSize = std::min(linearBufferMaxSize_, (linearBufferAllocatedSize_ * LINEAR_BUFFER_MULTIPLIER) + nextSavedCount);
-                    unsigned char* nextLinearBuffer = new unsigned char[allocatedSize];
-                    std::memcpy(nextLinearBuffer, linearBuffer_, linearBufferAllocatedSize_);
-                    delete[]linearBuffer_;
-                    linearBuffer_ = nextLinearBuffer;
-                    linearBufferAllocatedSize_ = allocatedSize;
+                else if (unsigned char* inBuffer = reserveInBuffer(nextSavedCount)) {
+                    reservedBuffer = inBuffer + inBufferSavedCount_;
                 }
                 else {
-                    if (buffer >= linearBuffer_ && buffer <= (linearBuffer_ + linearBufferAllocatedSize_)) {
-                        return BufferComposerSaveStatus::BufferIsOverlapping;
-                    }
+                    reservedBuffer = reserveInChunks(reserveSize);
                 }
+            }
+            catch (const std::bad_alloc&) {
+                return BufferComposerSaveStatus::MemoryBudgetIsExceeded;
+            }
+
+            reservedSize_ = reserveSize;
+
+            return BufferComposerSaveStatus::Success;
+        }
+
+        BufferComposerSaveStatus commit(size_t committedSize) noexcept
+        {
+            if (committedSize > reservedSize_) {
+                return BufferComposerSaveStatus::CommitIsOverReserved;
+            }
 
-                if (savedCount_ > 0 && savedCount_ <= STACK_BUFFER_MAX) {
-                    std::memcpy(static_cast<unsigned char*>(linearBuffer_), stackBuffer_, savedCount_);
+            reservedSize_ = 0;
+
+            if (committedSize > 0) {
+                checksum_.update(savedEnd(), committedSize);
+            }
+
+            if (chunks_.empty()) {
+                if (!inSpill_) {
+                    inBufferSavedCount_ += committedSize;
                 }
+            }
+            else {
+                chunks_.back().size += committedSize;
 
-                std::memcpy(static_cast<unsigned char*>(linearBuffer_ + savedCount_), buffer, bufferSize);
-                savedCount_ = nextSavedCount;
-                inBufferSavedCount_ = savedCount_;
-                return BufferComposerSaveStatus::Success;
+                if (chunks_.back().size == 0) {
+                    releaseLastChunk();
+                }
             }
 
-            chunks_.emplace_back();
-            Chunk& chunk = chunks_.back();
-            chunk.first = new unsigned char[bufferSize];
-            memcpy(chunk.first, buffer, bufferSize);
-            chunk.second = bufferSize;
-            savedCount_ = nextSavedCount;
+            if (committedSize > 0) {
+                statistics_.onSave(committedSize);
+            }
+            savedCount_ += committedSize;
 
             return BufferComposerSaveStatus::Success;
         }
 
+        // composedData stays valid until the composer is changed. A compose() after more saves extends the data
+        // composed before: chunks saved since are appended to it, growing it by GROWTH_POLICY up to
+        // linearBufferMaxSize and by LINEAR_BUFFER_MULTIPLIER past it, so composing after every few saves
+        // copies each byte amortized O(1) times. It may move saved data, so it is refused while a reserve() is open.
         BufferComposerComposeStatus compose(unsigned char*& composedData, size_t& composedDataSize) noexcept
         {
-            if (savedCount_ == 0) {
-                return BufferComposerComposeStatus::NoDataSaved;
+            if (reservedSize_ > 0) {
+                return BufferComposerComposeStatus::NotCommittedAfterReserve;
             }
 
-            composedDataSize = savedCount_;
-            savedCount_ = COMPOSED_BUFFER_IS_NOT_RESET_FLAG;
+            const size_t liveCount = savedCount();
 
-            if (composedDataSize <= STACK_BUFFER_MAX) {
-                composedData = stackBuffer_;
-                return BufferComposerComposeStatus::Success;
+            if (liveCount == 0) {
+                return BufferComposerComposeStatus::NoDataSaved;
             }
 
-            if (composedDataSize <= linearBufferMaxSize_) {
-                composedData = linearBuffer_;
+            composedDataSize = liveCount;
+
+            if (inSpill_) {
+                composedData = extensions_->spillBuffer.data() + consumedCount_;
                 return BufferComposerComposeStatus::Success;
             }
 
-            if (composedBufferFromChunks_) {
-                composedData = composedBufferFromChunks_;
+            if (chunks_.empty()) {
+                composedData = inBuffer() + consumedCount_;
                 return BufferComposerComposeStatus::Success;
             }
 
-            if (chunks_.empty()) {
-                return BufferComposerComposeStatus::NoChunkSaved;
+            if (inBufferSavedCount_ > (inLinearBuffer_ ? linearBufferAllocatedSize_ : STACK_BUFFER_MAX)) {
+                return BufferComposerComposeStatus::LogicErrorWhenComposingFromBuffer;
             }
 
-            composedBufferFromChunks_ = new unsigned char[composedDataSize];
-            size_t writtenToComposedBuffer = 0;
+            // Live bytes of the linear buffer stay in place and chunks are appended after them,
+            // otherwise everything goes to the start of the linear buffer or of a new one
+            const bool isAppending = inLinearBuffer_ && consumedCount_ < inBufferSavedCount_;
+            const size_t skippedSize = isAppending ? inBufferSavedCount_ - consumedCount_ : 0;
+            unsigned char* composedBuffer = nullptr;
 
-            if (inBufferSavedCount_ > 0) {
-                if (inBufferSavedCount_ <= STACK_BUFFER_MAX) {
-                    std::memcpy(composedBufferFromChunks_, stackBuffer_, inBufferSavedCount_);
-                    writtenToComposedBuffer = inBufferSavedCount_;
+            try {
+                if (isAppending) {
+                    if (savedCount_ > linearBufferAllocatedSize_) {
+                        growLinearBuffer(composedBufferSize());
+                    }
+                    composedBuffer = linearBuffer_ + inBufferSavedCount_;
                 }
-                else if (inBufferSavedCount_ <= linearBufferMaxSize_) {
-                    std::memcpy(composedBufferFromChunks_, linearBuffer_, inBufferSavedCount_);
-                    writtenToComposedBuffer = inBufferSavedCount_;
+                else if (linearBufferAllocatedSize_ >= liveCount) {
+                    composedBuffer = linearBuffer_;
                 }
                 else {
-                    return BufferComposerComposeStatus::LogicErrorWhenComposingFromBuffer;
+                    composedBuffer = AllocatorTraits::allocate(allocator_, liveCount);
+                    statistics_.onAllocate(liveCount);
                 }
             }
+            catch (const std::bad_alloc&) {
+                return BufferComposerComposeStatus::MemoryBudgetIsExceeded;
+            }
+
+            statistics_.onTransition(BufferComposerTier::Chunks, BufferComposerTier::Composed);
+            size_t copiedSize = 0;
+            size_t segmentsOffset = 0;
 
-            for (Chunk& record : chunks_) {
-                if (!record.first || writtenToComposedBuffer + record.second > composedDataSize) {
-                    return BufferComposerComposeStatus::LogicErrorWhenComposingFromChunks;
+            const bool isComposedFromChunks = isComposedInParallel(liveCount - skippedSize) ?
+                composeInParallel(composedBuffer, skippedSize, copiedSize) :
+                forEachSegment([&](const unsigned char* data, size_t size)
+                {
+                    if (segmentsOffset + size > liveCount) {
+                        return false;
+                    }
+                    const size_t skipSize = std::min(size, skippedSize - std::min(skippedSize, segmentsOffset));
+                    std::memcpy(composedBuffer + copiedSize, data + skipSize, size - skipSize);
+                    copiedSize += size - skipSize;
+                    segmentsOffset += size;
+                    return true;
+                });
+
+            statistics_.onCopy(BufferComposerTier::Composed, copiedSize);
+
+            if (!isComposedFromChunks || skippedSize + copiedSize != liveCount) {
+                if (!isAppending && composedBuffer != linearBuffer_) {
+                    AllocatorTraits::deallocate(allocator_, composedBuffer, liveCount);
+                    statistics_.onDeallocate(liveCount);
                 }
-                std::memcpy(composedBufferFromChunks_ + writtenToComposedBuffer, record.first, record.second);
-                writtenToComposedBuffer += record.second;
+                return isComposedFromChunks ? BufferComposerComposeStatus::ComposedDataFromChunksDontMatchToSavedCount :
+                    BufferComposerComposeStatus::LogicErrorWhenComposingFromChunks;
+            }
 
-                delete[]record.first;
-                record.first = nullptr;
+            if (!isAppending) {
+                if (composedBuffer != linearBuffer_) {
+                    if (linearBuffer_) {
+                        AllocatorTraits::deallocate(allocator_, linearBuffer_, linearBufferAllocatedSize_);
+                        statistics_.onDeallocate(linearBufferAllocatedSize_);
+                    }
+                    linearBuffer_ = composedBuffer;
+                    linearBufferAllocatedSize_ = liveCount;
+                }
+                savedCount_ = liveCount;
+                consumedCount_ = 0;
             }
 
-            if (writtenToComposedBuffer != composedDataSize) {
-                return BufferComposerComposeStatus::ComposedDataFromChunksDontMatchToSavedCount;
+            releaseChunks();
+            inLinearBuffer_ = true;
+            inBufferSavedCount_ = savedCount_;
+            composedData = linearBuffer_ + consumedCount_;
+
+            return BufferComposerComposeStatus::Success;
+        }
+
+        BufferComposerComposeStatus compose(unsigned char*& composedData, size_t& composedDataSize, checksum_type& checksum) noexcept
+        {
+            const BufferComposerComposeStatus status = compose(composedData, composedDataSize);
+
+            if (status == BufferComposerComposeStatus::Success) {
+                checksum = checksum_.value();
             }
 
-            chunks_.clear();
+            return status;
+        }
+
+        // Checksum of the bytes saved since clear(), consume() does not change it
+        checksum_type checksum() const noexcept
+        {
+            return checksum_.value();
+        }
+
+        // Only a view of the saved data, a reserve() stays open and its span valid
+        BufferComposerComposeStatus composeSegments(BufferComposerSegment* segments, size_t segmentsCapacity,
+            size_t& segmentsCount, size_t& composedDataSize) noexcept
+        {
+            if (savedCount() == 0) {
+                return BufferComposerComposeStatus::NoDataSaved;
+            }
+
+            segmentsCount = this->segmentsCount();
+
+            if (segmentsCount > segmentsCapacity) {
+                return BufferComposerComposeStatus::SegmentsCapacityIsNotEnough;
+            }
+
+            size_t segmentIndex = 0;
+
+            return composeSegments([segments, &segmentIndex](const unsigned char* data, size_t size)
+            {
+                segments[segmentIndex++] = { data, size };
+            }, composedDataSize);
+        }
+
+        // Same view, onSegment(data, size) gets every segment in order instead of an array.
+        // Segments already passed are not taken back when another status than Success is returned.
+        template <typename FUNC>
+        BufferComposerComposeStatus composeSegments(FUNC&& onSegment, size_t& composedDataSize) noexcept
+        {
+            const size_t liveCount = savedCount();
+
+            if (liveCount == 0) {
+                return BufferComposerComposeStatus::NoDataSaved;
+            }
+
+            composedDataSize = liveCount;
+
+            if (inBufferSavedCount_ > (inLinearBuffer_ ? linearBufferAllocatedSize_ : STACK_BUFFER_MAX)) {
+                return BufferComposerComposeStatus::LogicErrorWhenComposingFromBuffer;
+            }
+
+            size_t segmentedSize = 0;
 
-            composedData = composedBufferFromChunks_;
+            const bool isSegmented = forEachSegment([&](const unsigned char* data, size_t size)
+            {
+                if (segmentedSize + size > liveCount) {
+                    return false;
+                }
+                onSegment(data, size);
+                segmentedSize += size;
+                return true;
+            });
+
+            if (!isSegmented) {
+                return BufferComposerComposeStatus::LogicErrorWhenComposingFromChunks;
+            }
+
+            if (segmentedSize != liveCount) {
+                return BufferComposerComposeStatus::ComposedDataFromChunksDontMatchToSavedCount;
+            }
 
             return BufferComposerComposeStatus::Success;
         }
 
+        size_t segmentsCount() const noexcept
+        {
+            size_t segmentsCount = 0;
+
+            forEachSegment([&segmentsCount](const unsigned char*, size_t)
+            {
+                ++segmentsCount;
+                return true;
+            });
+
+            return segmentsCount;
+        }
+
+        // Count of saved bytes which are not consumed yet
+        size_t savedCount() const noexcept
+        {
+            return savedCount_ - consumedCount_;
+        }
+
+        // First contiguous span of the saved data, empty when nothing is saved
+        BufferComposerSegment frontSegment() const noexcept
+        {
+            BufferComposerSegment segment;
+
+            forEachSegment([&segment](const unsigned char* data, size_t size)
+            {
+                segment = { data, size };
+                return false;
+            });
+
+            return segment;
+        }
+
+        // Copies up to size saved bytes starting at offset into dstBuffer, returns the copied count
+        size_t peek(size_t offset, unsigned char* dstBuffer, size_t size) const noexcept
+        {
+            size_t copiedSize = 0;
+
+            forEachSegment([&](const unsigned char* data, size_t segmentSize)
+            {
+                if (offset >= segmentSize) {
+                    offset -= segmentSize;
+                    return true;
+                }
+
+                const size_t toCopySize = std::min(segmentSize - offset, size - copiedSize);
+                std::memcpy(dstBuffer + copiedSize, data + offset, toCopySize);
+                copiedSize += toCopySize;
+                offset = 0;
+                return copiedSize < size;
+            });
+
+            return copiedSize;
+        }
+
+        // Drops consumedSize bytes from the front. Fully consumed chunks are freed, the rest of a single buffer
+        // is moved to its start once it is not larger than the consumed part, so moves stay amortized O(1) per byte.
+        BufferComposerConsumeStatus consume(size_t consumedSize) noexcept
+        {
+            if (reservedSize_ > 0) {
+                return BufferComposerConsumeStatus::NotCommittedAfterReserve;
+            }
+
+            if (consumedSize > savedCount()) {
+                return BufferComposerConsumeStatus::ConsumedSizeIsOverSaved;
+            }
+
+            consumedCount_ += consumedSize;
+
+            if (consumedCount_ == savedCount_) {
+                savedCount_ = 0;
+                consumedCount_ = 0;
+                inBufferSavedCount_ = 0;
+                inLinearBuffer_ = false;
+                releaseChunks();
+                releaseSpill();
+                return BufferComposerConsumeStatus::Success;
+            }
+
+            if (inSpill_) {
+                const size_t liveCount = savedCount();
+                if (consumedCount_ >= liveCount) {
+                    std::memmove(extensions_->spillBuffer.data(), extensions_->spillBuffer.data() + consumedCount_, liveCount);
+                    statistics_.onCopy(BufferComposerTier::Spill, liveCount);
+                    savedCount_ = liveCount;
+                    consumedCount_ = 0;
+                }
+                return BufferComposerConsumeStatus::Success;
+            }
+
+            if (inBufferSavedCount_ > 0 && consumedCount_ >= inBufferSavedCount_) {
+                savedCount_ -= inBufferSavedCount_;
+                consumedCount_ -= inBufferSavedCount_;
+                inBufferSavedCount_ = 0;
+            }
+
+            if (inBufferSavedCount_ == 0) {
+                size_t releasedChunksCount = 0;
+
+                while (consumedCount_ >= chunks_[releasedChunksCount].size) {
+                    savedCount_ -= chunks_[releasedChunksCount].size;
+                    consumedCount_ -= chunks_[releasedChunksCount].size;
+                    deallocateChunk(chunks_[releasedChunksCount]);
+                    ++releasedChunksCount;
+                }
+
+                chunks_.erase(chunks_.begin(), chunks_.begin() + releasedChunksCount);
+            }
+
+            const size_t liveCount = savedCount();
+
+            if (consumedCount_ >= liveCount) {
+                if (chunks_.empty()) {
+                    std::memmove(inBuffer(), inBuffer() + consumedCount_, liveCount);
+                    statistics_.onCopy(currentTier(), liveCount);
+                    inBufferSavedCount_ = liveCount;
+                    savedCount_ = liveCount;
+                    consumedCount_ = 0;
+                }
+                else if (chunks_.size() == 1 && inBufferSavedCount_ == 0 && !isReferenceChunk(chunks_[0])) {
+                    std::memmove(chunks_[0].data, chunks_[0].data + consumedCount_, liveCount);
+                    statistics_.onCopy(BufferComposerTier::Chunks, liveCount);
+                    chunks_[0].size = liveCount;
+                    savedCount_ = liveCount;
+                    consumedCount_ = 0;
+                }
+            }
+
+            return BufferComposerConsumeStatus::Success;
+        }
+
+        // A linear buffer which compose() grew over linearBufferMaxSize is freed
         void clear() noexcept
         {
             savedCount_ = 0;
+            consumedCount_ = 0;
             inBufferSavedCount_ = 0;
+            inLinearBuffer_ = false;
+            reservedSize_ = 0;
+            checksum_.reset();
+
+            releaseChunks();
+            releaseSpill();
 
-            for (Chunk& chunk : chunks_) {
-                delete[]chunk.first;
+            if (linearBufferAllocatedSize_ > linearBufferMaxSize_) {
+                AllocatorTraits::deallocate(allocator_, linearBuffer_, linearBufferAllocatedSize_);
+                statistics_.onDeallocate(linearBufferAllocatedSize_);
+                linearBuffer_ = nullptr;
+                linearBufferAllocatedSize_ = 0;
             }
+        }
 
-            chunks_.clear();
+        void cleanup() noexcept
+        {
+            clear();
+            chunks_ = std::vector<Chunk, ChunkAllocator>(chunks_.get_allocator());
 
-            delete[]composedBufferFromChunks_;
-            composedBufferFromChunks_ = nullptr;
+            if (linearBuffer_) {
+                AllocatorTraits::deallocate(allocator_, linearBuffer_, linearBufferAllocatedSize_);
+                statistics_.onDeallocate(linearBufferAllocatedSize_);
+                linearBuffer_ = nullptr;
+                linearBufferAllocatedSize_ = 0;
+            }
         }
 
-        void cleanup() noexcept
+        // Transfers the composed data to releasedBuffer without copying it, composing first if needed.
+        // Data held in the stack buffer or spilled is the only one copied into a new allocation. The composer is cleared,
+        // unless that allocation fails with MemoryBudgetIsExceeded. Refused while a reserve() is open.
+        BufferComposerComposeStatus release(buffer_type& releasedBuffer) noexcept
         {
+            if (reservedSize_ > 0) {
+                return BufferComposerComposeStatus::NotCommittedAfterReserve;
+            }
+
+            const size_t liveCount = savedCount();
+
+            if (liveCount == 0) {
+                return BufferComposerComposeStatus::NoDataSaved;
+            }
+
+            if (inSpill_) {
+                unsigned char* releasedData = allocateReleased(liveCount);
+                if (!releasedData) {
+                    return BufferComposerComposeStatus::MemoryBudgetIsExceeded;
+                }
+                std::memcpy(releasedData, extensions_->spillBuffer.data() + consumedCount_, liveCount);
+                statistics_.onCopy(BufferComposerTier::Composed, liveCount);
+                releasedBuffer = buffer_type(releasedData, liveCount, liveCount, allocator_);
+                clear();
+                return BufferComposerComposeStatus::Success;
+            }
+
+            if (!chunks_.empty()) {
+                unsigned char* composedData = nullptr;
+                size_t composedDataSize = 0;
+                const BufferComposerComposeStatus status = compose(composedData, composedDataSize);
+                if (status != BufferComposerComposeStatus::Success) {
+                    return status;
+                }
+            }
+
+            if (consumedCount_ > 0) {
+                std::memmove(inBuffer(), inBuffer() + consumedCount_, liveCount);
+                statistics_.onCopy(currentTier(), liveCount);
+                inBufferSavedCount_ = liveCount;
+                savedCount_ = liveCount;
+                consumedCount_ = 0;
+            }
+
+            unsigned char* releasedData = inLinearBuffer_ ? linearBuffer_ : allocateReleased(liveCount);
+            if (!releasedData) {
+                return BufferComposerComposeStatus::MemoryBudgetIsExceeded;
+            }
+
+            if (inLinearBuffer_) {
+                releasedBuffer = buffer_type(linearBuffer_, liveCount, linearBufferAllocatedSize_, allocator_);
+                statistics_.onDeallocate(linearBufferAllocatedSize_);
+                linearBuffer_ = nullptr;
+                linearBufferAllocatedSize_ = 0;
+            }
+            else {
+                std::memcpy(releasedData, stackBuffer_, liveCount);
+                statistics_.onCopy(BufferComposerTier::Composed, liveCount);
+                releasedBuffer = buffer_type(releasedData, liveCount, liveCount, allocator_);
+            }
+
             clear();
 
-            delete[]linearBuffer_;
-            linearBuffer_ = nullptr;
-            linearBufferAllocatedSize_ = 0;
+            return BufferComposerComposeStatus::Success;
+        }
+
+        // Takes a buffer back as the linear buffer when it is larger than the current one, fits linearBufferMaxSize
+        // and comes from an equal allocator. Otherwise the buffer is freed. Returns whether it was adopted.
+        bool adopt(buffer_type&& adoptedBuffer) noexcept
+        {
+            buffer_type buffer = std::move(adoptedBuffer);
+
+            if (inLinearBuffer_ || !buffer.data() || buffer.get_allocator() != allocator_ ||
+                buffer.capacity() <= linearBufferAllocatedSize_ || buffer.capacity() > linearBufferMaxSize_) {
+                return false;
+            }
+
+            if (linearBuffer_) {
+                AllocatorTraits::deallocate(allocator_, linearBuffer_, linearBufferAllocatedSize_);
+                statistics_.onDeallocate(linearBufferAllocatedSize_);
+            }
+
+            linearBufferAllocatedSize_ = buffer.capacity();
+            linearBuffer_ = buffer.release();
+            statistics_.onAllocate(linearBufferAllocatedSize_);
+
+            return true;
+        }
+
+        // Saves which make more than spillThreshold bytes saved move all data into a file mapping created
+        // in spillDirectory (memfd or /tmp when empty), every later save goes there until clear().
+        // Zero threshold disables spilling. Returns false when data is spilled already.
+        // The threshold and the mapping live in the heap block of extensions, allocated by the first enable call.
+        bool enableSpill(size_t spillThreshold, std::string spillDirectory = {})
+        {
+            if (inSpill_) {
+                return false;
+            }
+
+            if (spillThreshold == 0) {
+                if (extensions_) {
+                    extensions_->spillThreshold = 0;
+                    extensions_->spillBuffer = mapped_buffer();
+                    releaseUnusedExtensions();
+                }
+                return true;
+            }
+
+            Extensions& settings = enableExtensions();
+            settings.spillThreshold = spillThreshold;
+            settings.spillBuffer = mapped_buffer(std::move(spillDirectory));
+
+            return true;
+        }
+
+        // A compose() copying at least parallelComposeThreshold bytes from chunks is split between workers and
+        // the calling thread; the output bypasses the cache, it is usually sent rather than read back.
+        // workers must outlive the composer, nullptr disables it.
+        void enableParallelCompose(copy_workers* workers, size_t parallelComposeThreshold)
+        {
+            if (!workers) {
+                if (extensions_) {
+                    extensions_->composeWorkers = nullptr;
+                    releaseUnusedExtensions();
+                }
+                return;
+            }
+
+            Extensions& settings = enableExtensions();
+            settings.composeWorkers = workers;
+            settings.parallelComposeThreshold = parallelComposeThreshold;
+        }
+
+        // Whether saved data lives in the spill mapping
+        bool isSpilled() const noexcept
+        {
+            return inSpill_;
+        }
+
+        allocator_type get_allocator() const noexcept
+        {
+            return allocator_;
+        }
+
+        const STATISTICS& statistics() const noexcept
+        {
+            return statistics_;
+        }
+
+        STATISTICS& statistics() noexcept
+        {
+            return statistics_;
         }
 
     private:
-        using Chunk = std::pair<unsigned char*, size_t>;
+        Extensions& enableExtensions()
+        {
+            if (!extensions_) {
+                extensions_ = std::make_unique<Extensions>();
+            }
+
+            return *extensions_;
+        }
+
+        void releaseUnusedExtensions() noexcept
+        {
+            if (extensions_->spillThreshold == 0 && !extensions_->composeWorkers) {
+                extensions_.reset();
+            }
+        }
+
+        // Statistics taken over from a composer whose storage was freed get the storage of this one
+        void reportStorage() noexcept
+        {
+            if (linearBuffer_) {
+                statistics_.onAllocate(linearBufferAllocatedSize_);
+            }
+
+            for (const Chunk& chunk : chunks_) {
+                if (!isReferenceChunk(chunk)) {
+                    statistics_.onAllocate(chunk.capacity);
+                }
+            }
+
+            if (extensions_ && extensions_->spillBuffer.capacity() > 0) {
+                statistics_.onAllocate(extensions_->spillBuffer.capacity());
+            }
+        }
+
+        void moveStorageFrom(buffer_composer& source) noexcept
+        {
+            savedCount_ = std::exchange(source.savedCount_, 0);
+            consumedCount_ = std::exchange(source.consumedCount_, 0);
+            linearBuffer_ = std::exchange(source.linearBuffer_, nullptr);
+            linearBufferAllocatedSize_ = std::exchange(source.linearBufferAllocatedSize_, 0);
+            inBufferSavedCount_ = std::exchange(source.inBufferSavedCount_, 0);
+            inLinearBuffer_ = std::exchange(source.inLinearBuffer_, false);
+            reservedSize_ = std::exchange(source.reservedSize_, 0);
+            extensions_ = std::move(source.extensions_);
+            inSpill_ = std::exchange(source.inSpill_, false);
+            statistics_ = std::exchange(source.statistics_, STATISTICS());
+            checksum_ = std::exchange(source.checksum_, CHECKSUM());
+            source.chunks_.clear();
+
+            if (!inLinearBuffer_) {
+                std::memcpy(stackBuffer_, source.stackBuffer_, inBufferSavedCount_);
+            }
+        }
+
+        // Returns false when a segment of the source is not saved
+        bool copyDataFrom(const buffer_composer& source) noexcept
+        {
+            return source.forEachSegment([this](const unsigned char* data, size_t size)
+            {
+                return save(data, size) == BufferComposerSaveStatus::Success;
+            });
+        }
+
+        // nullptr when the allocation fails
+        unsigned char* allocateReleased(size_t size) noexcept
+        {
+            try {
+                return AllocatorTraits::allocate(allocator_, size);
+            }
+            catch (const std::bad_alloc&) {
+                return nullptr;
+            }
+        }
+
+        static bool isOverlapping(const unsigned char* buffer, size_t bufferSize, const unsigned char* storage, size_t storageSize) noexcept
+        {
+            return storage && (buffer < storage + storageSize) && (storage < buffer + bufferSize);
+        }
+
+        unsigned char* inBuffer() noexcept
+        {
+            return inLinearBuffer_ ? linearBuffer_ : stackBuffer_;
+        }
+
+        const unsigned char* inBuffer() const noexcept
+        {
+            return inLinearBuffer_ ? linearBuffer_ : stackBuffer_;
+        }
+
+        // Calls func(data, size) for every non-empty span of saved data after the consumed bytes, in order,
+        // until func returns false. Returns false when stopped.
+        template <typename FUNC>
+        bool forEachSegment(FUNC&& func) const
+        {
+            if (savedCount() == 0) {
+                return true;
+            }
+
+            if (inSpill_) {
+                return func(static_cast<const unsigned char*>(extensions_->spillBuffer.data() + consumedCount_), savedCount());
+            }
+
+            size_t skippedSize = consumedCount_;
+            auto visit = [&skippedSize, &func](const unsigned char* data, size_t size)
+            {
+                const size_t skipSize = std::min(skippedSize, size);
+                skippedSize -= skipSize;
+                return size == skipSize || func(data + skipSize, size - skipSize);
+            };
+
+            if (!visit(inBuffer(), inBufferSavedCount_)) {
+                return false;
+            }
+
+            for (const Chunk& chunk : chunks_) {
+                if (!visit(chunk.data, chunk.size)) {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        // Where the next saved byte goes
+        unsigned char* savedEnd() noexcept
+        {
+            if (inSpill_) {
+                return extensions_->spillBuffer.data() + savedCount_;
+            }
+
+            if (!chunks_.empty()) {
+                return chunks_.back().data + chunks_.back().size;
+            }
+
+            return inBuffer() + inBufferSavedCount_;
+        }
+
+        BufferComposerTier currentTier() const noexcept
+        {
+            if (inSpill_) {
+                return BufferComposerTier::Spill;
+            }
+
+            if (!chunks_.empty()) {
+                return BufferComposerTier::Chunks;
+            }
+
+            return inLinearBuffer_ ? BufferComposerTier::Linear : BufferComposerTier::Stack;
+        }
+
+        BufferComposerSaveStatus checkSave(const unsigned char* buffer, size_t bufferSize) const noexcept
+        {
+            if (reservedSize_ > 0) {
+                return BufferComposerSaveStatus::NotCommittedAfterReserve;
+            }
+
+            if (!buffer) {
+                return BufferComposerSaveStatus::NullBuffer;
+            }
+
+            if (bufferSize == 0) {
+                return BufferComposerSaveStatus::ZeroBufferSize;
+            }
+
+            if (savedCount() + bufferSize > saveBufferMaxCount_) {
+                return BufferComposerSaveStatus::MaxSavedBufferCountLimited;
+            }
+
+            if (isOverlapping(buffer, bufferSize, stackBuffer_, STACK_BUFFER_MAX) ||
+                isOverlapping(buffer, bufferSize, linearBuffer_, linearBufferAllocatedSize_) ||
+                (extensions_ && isOverlapping(buffer, bufferSize, extensions_->spillBuffer.data(), extensions_->spillBuffer.capacity()))) {
+                return BufferComposerSaveStatus::BufferIsOverlapping;
+            }
+
+            return BufferComposerSaveStatus::Success;
+        }
+
+        bool isSpilling(size_t size) const noexcept
+        {
+            return inSpill_ || (extensions_ && extensions_->spillThreshold > 0 && savedCount() + size > extensions_->spillThreshold);
+        }
+
+        bool isComposedInParallel(size_t copiedSize) const noexcept
+        {
+            return extensions_ && extensions_->composeWorkers && copiedSize >= extensions_->parallelComposeThreshold;
+        }
+
+        // Returns the end of the spilled data with room for size more bytes, moving the data from the heap
+        // tiers into the mapping first. The mapping grows by LINEAR_BUFFER_MULTIPLIER, remapping does not copy.
+        // Returns nullptr when the mapping fails, the data stays where it was then.
+        unsigned char* reserveInSpill(size_t size) noexcept
+        {
+            mapped_buffer& spillBuffer = extensions_->spillBuffer;
+            const size_t liveCount = savedCount();
+            const size_t nextSavedCount = (inSpill_ ? savedCount_ : liveCount) + size;
+
+            if (nextSavedCount > spillBuffer.capacity()) {
+                const size_t capacity = std::max(nextSavedCount, std::min(saveBufferMaxCount_,
+                    std::max(spillBuffer.capacity(), extensions_->spillThreshold) * LINEAR_BUFFER_MULTIPLIER));
+                const size_t previousCapacity = spillBuffer.capacity();
+                if (!spillBuffer.reserve(capacity)) {
+                    return nullptr;
+                }
+                if (previousCapacity == 0) {
+                    statistics_.onAllocate(spillBuffer.capacity());
+                }
+                else {
+                    statistics_.onReallocate(previousCapacity, spillBuffer.capacity());
+                }
+            }
+
+            if (!inSpill_) {
+                size_t spilledSize = 0;
+                forEachSegment([&spillBuffer, &spilledSize](const unsigned char* data, size_t size)
+                {
+                    std::memcpy(spillBuffer.data() + spilledSize, data, size);
+                    spilledSize += size;
+                    return true;
+                });
+
+                statistics_.onTransition(currentTier(), BufferComposerTier::Spill);
+                statistics_.onCopy(BufferComposerTier::Spill, spilledSize);
+                releaseChunks();
+                inBufferSavedCount_ = 0;
+                inLinearBuffer_ = false;
+                savedCount_ = liveCount;
+                consumedCount_ = 0;
+                inSpill_ = true;
+            }
+
+            return spillBuffer.data() + savedCount_;
+        }
+
+        void releaseSpill() noexcept
+        {
+            if (extensions_ && extensions_->spillBuffer.capacity() > 0) {
+                statistics_.onDeallocate(extensions_->spillBuffer.capacity());
+                extensions_->spillBuffer.reset();
+            }
+
+            inSpill_ = false;
+        }
+
+        // Copies the live bytes past the first skippedSize ones. Offsets of all segments in the output are known
+        // up front: each part sums segment sizes up to its range and streams the overlapping ones,
+        // so no thread waits for another
+        bool composeInParallel(unsigned char* composedBuffer, size_t skippedSize, size_t& copiedSize) noexcept
+        {
+            size_t segmentsSize = 0;
+            forEachSegment([&segmentsSize](const unsigned char*, size_t size)
+            {
+                segmentsSize += size;
+                return true;
+            });
+
+            if (segmentsSize > savedCount() || segmentsSize < skippedSize) {
+                return false;
+            }
+
+            copiedSize = segmentsSize - skippedSize;
+            const size_t partsCount = extensions_->composeWorkers->concurrency();
+            extensions_->composeWorkers->run(partsCount, [this, composedBuffer, partsCount, skippedSize, copiedSize](size_t part)
+            {
+                const size_t begin = skippedSize + copiedSize / partsCount * part + std::min(part, copiedSize % partsCount);
+                const size_t end = begin + copiedSize / partsCount + (part < copiedSize % partsCount ? 1 : 0);
+                size_t offset = 0;
+
+                forEachSegment([&](const unsigned char* data, size_t size)
+                {
+                    const size_t from = std::max(offset, begin);
+                    const size_t to = std::min(offset + size, end);
+                    if (from < to) {
+                        streamCopy(composedBuffer + (from - skippedSize), data + (from - offset), to - from);
+                    }
+                    offset += size;
+                    return offset < end;
+                });
+            });
+
+            return true;
+        }
+
+        // Returns the stack or linear buffer that fits nextSavedCount bytes, nullptr when data goes to chunks
+        unsigned char* reserveInBuffer(size_t nextSavedCount)
+        {
+            if (!chunks_.empty()) {
+                return nullptr;
+            }
+
+            if (!inLinearBuffer_ && nextSavedCount <= STACK_BUFFER_MAX) {
+                return stackBuffer_;
+            }
+
+            // a buffer composed from chunks may be larger than linearBufferMaxSize
+            if (nextSavedCount > std::max(linearBufferMaxSize_, linearBufferAllocatedSize_)) {
+                return nullptr;
+            }
+
+            if (!linearBuffer_) {
+                const size_t allocatedSize = GROWTH_POLICY::initialSize(nextSavedCount, linearBufferMaxSize_);
+                linearBuffer_ = AllocatorTraits::allocate(allocator_, allocatedSize);
+                linearBufferAllocatedSize_ = allocatedSize;
+                statistics_.onAllocate(allocatedSize);
+            }
+            else if (nextSavedCount > linearBufferAllocatedSize_) {
+                growLinearBuffer(GROWTH_POLICY::nextSize(linearBufferAllocatedSize_, nextSavedCount, linearBufferMaxSize_));
+            }
+
+            if (!inLinearBuffer_) {
+                if (inBufferSavedCount_ > 0) {
+                    std::memcpy(linearBuffer_, stackBuffer_, inBufferSavedCount_);
+                    statistics_.onCopy(BufferComposerTier::Linear, inBufferSavedCount_);
+                }
+                statistics_.onTransition(BufferComposerTier::Stack, BufferComposerTier::Linear);
+                inLinearBuffer_ = true;
+            }
+
+            return linearBuffer_;
+        }
+
+        // Up to linearBufferMaxSize the composed buffer grows by GROWTH_POLICY, past it by LINEAR_BUFFER_MULTIPLIER,
+        // so a policy which allocates its maximum at once does not allocate saveBufferMaxCount
+        size_t composedBufferSize() const noexcept
+        {
+            if (savedCount_ <= linearBufferMaxSize_) {
+                return std::max(savedCount_, GROWTH_POLICY::nextSize(linearBufferAllocatedSize_, savedCount_, linearBufferMaxSize_));
+            }
+
+            return std::max(savedCount_, std::min(saveBufferMaxCount_, linearBufferAllocatedSize_ * LINEAR_BUFFER_MULTIPLIER));
+        }
+
+        // Only bytes saved in the linear buffer and not consumed are moved, none when it is not in use
+        void growLinearBuffer(size_t allocatedSize)
+        {
+            const size_t liveBegin = inLinearBuffer_ ? std::min(consumedCount_, inBufferSavedCount_) : 0;
+            const size_t liveEnd = inLinearBuffer_ ? inBufferSavedCount_ : 0;
+
+            if constexpr (IS_ALLOCATOR_REALLOCATING) {
+                linearBuffer_ = allocator_.reallocate(linearBuffer_, linearBufferAllocatedSize_, liveBegin, liveEnd, allocatedSize);
+            }
+            else {
+                unsigned char* nextLinearBuffer = AllocatorTraits::allocate(allocator_, allocatedSize);
+                std::memcpy(nextLinearBuffer + liveBegin, linearBuffer_ + liveBegin, liveEnd - liveBegin);
+                AllocatorTraits::deallocate(allocator_, linearBuffer_, linearBufferAllocatedSize_);
+                linearBuffer_ = nextLinearBuffer;
+                statistics_.onCopy(BufferComposerTier::Linear, liveEnd - liveBegin);
+            }
+
+            statistics_.onReallocate(linearBufferAllocatedSize_, allocatedSize);
+            linearBufferAllocatedSize_ = allocatedSize;
+        }
+
+        static bool isReferenceChunk(const Chunk& chunk) noexcept
+        {
+            return chunk.capacity == 0;
+        }
+
+        static size_t chunkFreeSize(const Chunk& chunk) noexcept
+        {
+            return isReferenceChunk(chunk) ? 0 : chunk.capacity - chunk.size;
+        }
+
+        unsigned char* reserveInChunks(size_t reserveSize)
+        {
+            if (chunks_.empty() || chunkFreeSize(chunks_.back()) < reserveSize) {
+                allocateChunk(reserveSize);
+            }
+
+            Chunk& tail = chunks_.back();
+            return tail.data + tail.size;
+        }
+
+        // The next chunk is allocated before anything is copied, a failed allocation leaves the chunks as they were
+        void saveToChunks(const unsigned char* buffer, size_t bufferSize)
+        {
+            size_t chunkIndex = chunks_.empty() ? 0 : chunks_.size() - 1;
+            const size_t tailFreeSize = chunks_.empty() ? 0 : chunkFreeSize(chunks_.back());
+
+            if (bufferSize > tailFreeSize) {
+                allocateChunk(bufferSize - tailFreeSize);
+            }
+
+            for (; bufferSize > 0; ++chunkIndex) {
+                Chunk& chunk = chunks_[chunkIndex];
+                const size_t chunkSavedSize = std::min(chunkFreeSize(chunk), bufferSize);
+                checksum_.copy(chunk.data + chunk.size, buffer, chunkSavedSize);
+                chunk.size += chunkSavedSize;
+                buffer += chunkSavedSize;
+                bufferSize -= chunkSavedSize;
+            }
+        }
+
+        // The index grows before a chunk is allocated, so a failed push_back() cannot leak the chunk
+        void growChunksIndex()
+        {
+            if (chunks_.size() == chunks_.capacity()) {
+                chunks_.reserve(chunks_.empty() ? 4 : chunks_.capacity() * 2);
+            }
+        }
+
+        Chunk& allocateChunk(size_t minCapacity)
+        {
+            growChunksIndex();
+
+            const size_t capacity = ((minCapacity + CHUNK_BLOCK_SIZE - 1) / CHUNK_BLOCK_SIZE) * CHUNK_BLOCK_SIZE;
+            ChunkLineAllocator lineAllocator(allocator_);
+            ChunkLine* lines = std::allocator_traits<ChunkLineAllocator>::allocate(lineAllocator, capacity / CHUNK_ALIGNMENT);
+            statistics_.onAllocate(capacity);
+            if (chunks_.empty()) {
+                statistics_.onTransition(currentTier(), BufferComposerTier::Chunks);
+            }
+            chunks_.push_back({ reinterpret_cast<unsigned char*>(lines), 0, capacity });
+            return chunks_.back();
+        }
+
+        void deallocateChunk(const Chunk& chunk) noexcept
+        {
+            if (isReferenceChunk(chunk)) {
+                return;
+            }
+
+            ChunkLineAllocator lineAllocator(allocator_);
+            std::allocator_traits<ChunkLineAllocator>::deallocate(lineAllocator,
+                reinterpret_cast<ChunkLine*>(chunk.data), chunk.capacity / CHUNK_ALIGNMENT);
+            statistics_.onDeallocate(chunk.capacity);
+        }
+
+        void releaseLastChunk() noexcept
+        {
+            deallocateChunk(chunks_.back());
+            chunks_.pop_back();
+        }
+
+        void releaseChunks() noexcept
+        {
+            for (const Chunk& chunk : chunks_) {
+                deallocateChunk(chunk);
+            }
+
+            chunks_.clear();
+        }
 
         size_t linearBufferMaxSize_;
         size_t saveBufferMaxCount_;
         size_t savedCount_ = 0;
+        size_t consumedCount_ = 0;
         unsigned char* linearBuffer_ = nullptr;
         size_t linearBufferAllocatedSize_ = 0;
         size_t inBufferSavedCount_ = 0;
-        unsigned char* composedBufferFromChunks_ = nullptr;
-        std::list<Chunk> chunks_;
+        bool inLinearBuffer_ = false;
+        bool inSpill_ = false;
+        size_t reservedSize_ = 0;
+        std::vector<Chunk, ChunkAllocator> chunks_;
+        std::unique_ptr<Extensions> extensions_;
+        RESTOOLS_NO_UNIQUE_ADDRESS ALLOCATOR allocator_;
+        RESTOOLS_NO_UNIQUE_ADDRESS STATISTICS statistics_;
+        RESTOOLS_NO_UNIQUE_ADDRESS CHECKSUM checksum_;
         unsigned char stackBuffer_[STACK_BUFFER_MAX];
     };
+
+    namespace pmr
+    {
+        template <size_t STACK_BUFFER_MAX = 256 /*256b*/,
+            uint16_t LINEAR_BUFFER_MULTIPLIER = 2,
+            size_t CHUNK_BLOCK_SIZE = 4096 /*4kb*/,
+            typename STATISTICS = buffer_composer_no_statistics,
+            typename GROWTH_POLICY = geometric_growth<LINEAR_BUFFER_MULTIPLIER>,
+            typename CHECKSUM = buffer_composer_no_checksum>
+        using buffer_composer = restools::buffer_composer<STACK_BUFFER_MAX, LINEAR_BUFFER_MULTIPLIER, CHUNK_BLOCK_SIZE,
+            std::pmr::polymorphic_allocator<unsigned char>, STATISTICS, GROWTH_POLICY, CHECKSUM>;
+    }
 }
\ No newline at end of file
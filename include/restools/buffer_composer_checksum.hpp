@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring> // memcpy
+
+#include "restools/crc32c.hpp"
+
+namespace restools
+{
+    // Default CHECKSUM of buffer_composer, saves are plain copies and the member takes no space
+    struct buffer_composer_no_checksum
+    {
+        using value_type = uint32_t;
+
+        void copy(unsigned char* dst, const unsigned char* src, size_t size) noexcept
+        {
+            std::memcpy(dst, src, size);
+        }
+
+        void update(const unsigned char*, size_t) noexcept {}
+        void reset() noexcept {}
+
+        value_type value() const noexcept
+        {
+            return 0;
+        }
+    };
+
+    // Running CRC32C of saved bytes, computed by the copy into the composer (SSE4.2 when available)
+    class crc32c_checksum
+    {
+    public:
+        using value_type = uint32_t;
+
+        void copy(unsigned char* dst, const unsigned char* src, size_t size) noexcept
+        {
+            crc_ = crc32cCopy(dst, src, size, crc_);
+        }
+
+        void update(const unsigned char* data, size_t size) noexcept
+        {
+            crc_ = crc32c(data, size, crc_);
+        }
+
+        void reset() noexcept
+        {
+            crc_ = 0;
+        }
+
+        value_type value() const noexcept
+        {
+            return crc_;
+        }
+
+    private:
+        uint32_t crc_ = 0;
+    };
+}
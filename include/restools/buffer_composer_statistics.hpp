@@ -0,0 +1,125 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+
+// Empty policy members take no space. MSVC ignores the standard attribute for ABI compatibility
+// and only honours its own spelling.
+#if defined(_MSC_VER)
+#define RESTOOLS_NO_UNIQUE_ADDRESS [[msvc::no_unique_address]]
+#else
+#define RESTOOLS_NO_UNIQUE_ADDRESS [[no_unique_address]]
+#endif
+
+namespace restools
+{
+    enum class BufferComposerTier : short
+    {
+        Stack,
+        Linear,
+        Chunks,
+        Spill,
+        Composed,
+    };
+
+    // Default STATISTICS of buffer_composer, every hook is empty and the member takes no space
+    struct buffer_composer_no_statistics
+    {
+        void onSave(size_t) noexcept {}
+        void onCopy(BufferComposerTier, size_t) noexcept {}
+        void onTransition(BufferComposerTier, BufferComposerTier) noexcept {}
+        void onAllocate(size_t) noexcept {}
+        void onReallocate(size_t, size_t) noexcept {}
+        void onDeallocate(size_t) noexcept {}
+    };
+
+    // Counters of one composer. A STATISTICS type with the same hooks can forward them elsewhere instead,
+    // e.g. to process-wide atomics; merge() sums composers which are counted separately.
+    struct buffer_composer_statistics
+    {
+        static constexpr size_t TIERS_COUNT = static_cast<size_t>(BufferComposerTier::Composed) + 1;
+        // Bucket i counts saves of [2^i, 2^(i+1)) bytes, the last one counts everything above
+        static constexpr size_t SAVE_SIZE_HISTOGRAM_SIZE = 24;
+
+        size_t savesCount = 0;
+        size_t savedBytes = 0;
+        size_t saveSizeHistogram[SAVE_SIZE_HISTOGRAM_SIZE] = {};
+        // Bytes copied into each tier, including moves between tiers and compaction after consume()
+        size_t copiedBytes[TIERS_COUNT] = {};
+        // Transitions into each tier
+        size_t transitions[TIERS_COUNT] = {};
+        size_t allocationsCount = 0;
+        size_t reallocationsCount = 0;
+        size_t deallocationsCount = 0;
+        size_t footprint = 0;
+        size_t peakFootprint = 0;
+
+        void onSave(size_t size) noexcept
+        {
+            ++savesCount;
+            savedBytes += size;
+            ++saveSizeHistogram[std::min<size_t>(std::bit_width(size | 1) - 1, SAVE_SIZE_HISTOGRAM_SIZE - 1)];
+        }
+
+        void onCopy(BufferComposerTier tier, size_t size) noexcept
+        {
+            copiedBytes[static_cast<size_t>(tier)] += size;
+        }
+
+        void onTransition(BufferComposerTier, BufferComposerTier to) noexcept
+        {
+            ++transitions[static_cast<size_t>(to)];
+        }
+
+        void onAllocate(size_t size) noexcept
+        {
+            ++allocationsCount;
+            footprint += size;
+            peakFootprint = std::max(peakFootprint, footprint);
+        }
+
+        void onReallocate(size_t oldSize, size_t newSize) noexcept
+        {
+            ++reallocationsCount;
+            footprint = footprint - oldSize + newSize;
+            peakFootprint = std::max(peakFootprint, footprint);
+        }
+
+        void onDeallocate(size_t size) noexcept
+        {
+            ++deallocationsCount;
+            footprint -= size;
+        }
+
+        size_t copiedBytesTo(BufferComposerTier tier) const noexcept
+        {
+            return copiedBytes[static_cast<size_t>(tier)];
+        }
+
+        size_t transitionsTo(BufferComposerTier tier) const noexcept
+        {
+            return transitions[static_cast<size_t>(tier)];
+        }
+
+        // Sums counters, peak footprint is the largest one of a single composer
+        buffer_composer_statistics& merge(const buffer_composer_statistics& other) noexcept
+        {
+            savesCount += other.savesCount;
+            savedBytes += other.savedBytes;
+            for (size_t i = 0; i < SAVE_SIZE_HISTOGRAM_SIZE; ++i) {
+                saveSizeHistogram[i] += other.saveSizeHistogram[i];
+            }
+            for (size_t i = 0; i < TIERS_COUNT; ++i) {
+                copiedBytes[i] += other.copiedBytes[i];
+                transitions[i] += other.transitions[i];
+            }
+            allocationsCount += other.allocationsCount;
+            reallocationsCount += other.reallocationsCount;
+            deallocationsCount += other.deallocationsCount;
+            footprint += other.footprint;
+            peakFootprint = std::max(peakFootprint, other.peakFootprint);
+            return *this;
+        }
+    };
+}
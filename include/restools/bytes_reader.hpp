@@ -0,0 +1,163 @@
+#pragma once
+
+#include <bit> // endian
+#include <cstddef>
+#include <cstring> // memcpy
+
+#include "restools/bytes_to_type.hpp"
+#include "restools/bytes_to_type_array.hpp"
+#include "restools/varint.hpp"
+
+namespace restools
+{
+    // Cursor decoding values from a byte span. A group of fields is checked once, with require() or
+    // with a single variadic read(), and decoded with no further checks.
+    // Values are not checked for overlapping with the span.
+    class bytes_reader
+    {
+    public:
+        bytes_reader(const unsigned char* data, size_t size) noexcept
+            : data_(data)
+            , size_(size)
+        {
+        }
+
+        BytesToTypeStatus require(size_t size) const noexcept
+        {
+            return size <= size_ - position_ ? BytesToTypeStatus::Success : BytesToTypeStatus::BufferIsOverflow;
+        }
+
+        template <std::endian SRC_ENDIAN, typename... T>
+        void readFast(T&... values) noexcept
+        {
+            (readOneFast<SRC_ENDIAN>(values), ...);
+        }
+
+        template <std::endian SRC_ENDIAN, typename... T>
+        BytesToTypeStatus read(T&... values) noexcept
+        {
+            if (require((sizeof(T) + ...)) != BytesToTypeStatus::Success) {
+                return BytesToTypeStatus::BufferIsOverflow;
+            }
+
+            readFast<SRC_ENDIAN>(values...);
+
+            return BytesToTypeStatus::Success;
+        }
+
+        template <std::endian SRC_ENDIAN, typename T>
+        void readArrayFast(T* values, size_t count) noexcept
+        {
+            bytesToTypeArrayFast(data_ + position_, count, values, SRC_ENDIAN == std::endian::big);
+            position_ += count * sizeof(T);
+        }
+
+        template <std::endian SRC_ENDIAN, typename T>
+        BytesToTypeStatus readArray(T* values, size_t count) noexcept
+        {
+            if (count > (size_ - position_) / sizeof(T)) {
+                return BytesToTypeStatus::BufferIsOverflow;
+            }
+
+            readArrayFast<SRC_ENDIAN>(values, count);
+
+            return BytesToTypeStatus::Success;
+        }
+
+        template <typename T>
+        BytesToTypeStatus readVarint(T& value) noexcept
+        {
+            size_t readSize = 0;
+            const BytesToTypeStatus status = bytesToVarintSafe(data_ + position_, size_ - position_, value, readSize);
+
+            if (status == BytesToTypeStatus::Success) {
+                position_ += readSize;
+            }
+
+            return status;
+        }
+
+        template <typename T>
+        BytesToTypeStatus readVarintArray(T* values, size_t count) noexcept
+        {
+            size_t readSize = 0;
+            const BytesToTypeStatus status = bytesToVarintArraySafe(data_ + position_, size_ - position_, values, count, readSize);
+
+            if (status == BytesToTypeStatus::Success) {
+                position_ += readSize;
+            }
+
+            return status;
+        }
+
+        void readBytesFast(unsigned char* bytes, size_t size) noexcept
+        {
+            std::memcpy(bytes, data_ + position_, size);
+            position_ += size;
+        }
+
+        BytesToTypeStatus readBytes(unsigned char* bytes, size_t size) noexcept
+        {
+            if (require(size) != BytesToTypeStatus::Success) {
+                return BytesToTypeStatus::BufferIsOverflow;
+            }
+
+            readBytesFast(bytes, size);
+
+            return BytesToTypeStatus::Success;
+        }
+
+        void skipFast(size_t size) noexcept
+        {
+            position_ += size;
+        }
+
+        BytesToTypeStatus skip(size_t size) noexcept
+        {
+            if (require(size) != BytesToTypeStatus::Success) {
+                return BytesToTypeStatus::BufferIsOverflow;
+            }
+
+            skipFast(size);
+
+            return BytesToTypeStatus::Success;
+        }
+
+        const unsigned char* data() const noexcept
+        {
+            return data_;
+        }
+
+        const unsigned char* current() const noexcept
+        {
+            return data_ + position_;
+        }
+
+        size_t size() const noexcept
+        {
+            return size_;
+        }
+
+        size_t position() const noexcept
+        {
+            return position_;
+        }
+
+        size_t remaining() const noexcept
+        {
+            return size_ - position_;
+        }
+
+    private:
+        template <std::endian SRC_ENDIAN, typename T>
+        void readOneFast(T& value) noexcept
+        {
+            bytesToTypeFast<SRC_ENDIAN>(data_ + position_, value);
+            position_ += sizeof(T);
+        }
+
+        const unsigned char* data_;
+        size_t size_;
+        size_t position_ = 0;
+    };
+}
@@ -0,0 +1,237 @@
+#pragma once
+
+#include <algorithm>
+#include <bit> // endian
+#include <cstddef>
+#include <cstdint>
+#include <cstring> // memcpy
+#include <type_traits>
+
+#include "restools/bytes_to_type.hpp"
+#include "restools/cpu_features.hpp"
+
+namespace restools
+{
+    // A field of fixed-size records and the array its values are written to, one value per record.
+    // Arithmetic and enum fields of 1, 2, 4 or 8 bytes are supported.
+    struct record_column
+    {
+        template <typename T>
+        record_column(size_t fieldOffset, T* dstValues, bool isBigEndian) noexcept
+            : offset(fieldOffset)
+            , size(sizeof(T))
+            , isBigEndian(isBigEndian)
+            , dstBytes(reinterpret_cast<unsigned char*>(dstValues))
+        {
+            static_assert(std::is_arithmetic_v<T> || std::is_enum_v<T>, "T is not arithmetic or enum");
+            static_assert(sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8, "T is not 1, 2, 4 or 8 bytes");
+        }
+
+        size_t offset;
+        size_t size;
+        bool isBigEndian;
+        unsigned char* dstBytes;
+    };
+
+    namespace detail
+    {
+        // Records are split in tiles which stay in L1 while every column is filled from them,
+        // so the records are read from memory once however many columns there are
+        inline constexpr size_t COLUMNS_TILE_SIZE = 16 * 1024 /*16kb*/;
+
+        template <size_t VALUE_SIZE>
+        inline void extractColumnScalar(const unsigned char* srcBytes, size_t recordSize, size_t count, unsigned char* dstBytes,
+            bool needsReverse) noexcept
+        {
+            using U = typename UnsignedOfSize<VALUE_SIZE>::type;
+
+            for (size_t i = 0; i < count; ++i) {
+                U value;
+                std::memcpy(&value, srcBytes + i * recordSize, VALUE_SIZE);
+                if (needsReverse) {
+                    value = byteSwap(value);
+                }
+                std::memcpy(dstBytes + i * VALUE_SIZE, &value, VALUE_SIZE);
+            }
+        }
+
+#if defined(RESTOOLS_X86)
+        // Gathers 4 (8 byte fields) or 8 (narrower fields) records per step. Narrow fields are gathered as
+        // 4 bytes and packed with a shuffle, which also reverses bytes, so gatheredCount only counts records
+        // which have 4 readable bytes at the field.
+        template <size_t VALUE_SIZE>
+        RESTOOLS_TARGET("avx2")
+        void extractColumnAvx2(const unsigned char* srcBytes, size_t recordSize, size_t count, size_t gatheredCount,
+            unsigned char* dstBytes, bool needsReverse) noexcept
+        {
+            const int stride = static_cast<int>(recordSize);
+            size_t i = 0;
+
+            if constexpr (VALUE_SIZE == 8) {
+                const __m128i indexes = _mm_setr_epi32(0, stride, 2 * stride, 3 * stride);
+                const __m256i reverseMask = _mm256_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8,
+                    7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+
+                for (; i + 4 <= gatheredCount; i += 4) {
+                    __m256i values = _mm256_i32gather_epi64(reinterpret_cast<const long long*>(srcBytes + i * recordSize), indexes, 1);
+                    if (needsReverse) {
+                        values = _mm256_shuffle_epi8(values, reverseMask);
+                    }
+                    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dstBytes + i * 8), values);
+                }
+            }
+            else {
+                const __m256i indexes = _mm256_setr_epi32(0, stride, 2 * stride, 3 * stride, 4 * stride, 5 * stride, 6 * stride, 7 * stride);
+                __m256i packMask;
+
+                // -1 clears a byte; packed values are at the start of each 128-bit lane
+                if constexpr (VALUE_SIZE == 4) {
+                    packMask = needsReverse ? _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+                        3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12) : _mm256_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15,
+                        0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+                }
+                else if constexpr (VALUE_SIZE == 2) {
+                    packMask = needsReverse ? _mm256_setr_epi8(1, 0, 5, 4, 9, 8, 13, 12, -1, -1, -1, -1, -1, -1, -1, -1,
+                        1, 0, 5, 4, 9, 8, 13, 12, -1, -1, -1, -1, -1, -1, -1, -1) : _mm256_setr_epi8(0, 1, 4, 5, 8, 9, 12, 13, -1, -1, -1, -1, -1, -1, -1, -1,
+                        0, 1, 4, 5, 8, 9, 12, 13, -1, -1, -1, -1, -1, -1, -1, -1);
+                }
+                else {
+                    packMask = _mm256_setr_epi8(0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                        0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+                }
+
+                for (; i + 8 <= gatheredCount; i += 8) {
+                    const __m256i values = _mm256_shuffle_epi8(
+                        _mm256_i32gather_epi32(reinterpret_cast<const int*>(srcBytes + i * recordSize), indexes, 1), packMask);
+
+                    if constexpr (VALUE_SIZE == 4) {
+                        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dstBytes + i * 4), values);
+                    }
+                    else if constexpr (VALUE_SIZE == 2) {
+                        const __m256i packed = _mm256_permute4x64_epi64(values, 0x08);
+                        _mm_storeu_si128(reinterpret_cast<__m128i*>(dstBytes + i * 2), _mm256_castsi256_si128(packed));
+                    }
+                    else {
+                        const uint64_t low = static_cast<uint32_t>(_mm256_extract_epi32(values, 0));
+                        const uint64_t high = static_cast<uint32_t>(_mm256_extract_epi32(values, 4));
+                        const uint64_t packed = low | (high << 32);
+                        std::memcpy(dstBytes + i, &packed, 8);
+                    }
+                }
+            }
+
+            extractColumnScalar<VALUE_SIZE>(srcBytes + i * recordSize, recordSize, count - i, dstBytes + i * VALUE_SIZE, needsReverse);
+        }
+#endif
+
+        template <size_t VALUE_SIZE>
+        using ExtractColumnKernel = void (*)(const unsigned char*, size_t, size_t, size_t, unsigned char*, bool);
+
+        template <size_t VALUE_SIZE>
+        void extractColumnPortable(const unsigned char* srcBytes, size_t recordSize, size_t count, size_t,
+            unsigned char* dstBytes, bool needsReverse) noexcept
+        {
+            extractColumnScalar<VALUE_SIZE>(srcBytes, recordSize, count, dstBytes, needsReverse);
+        }
+
+        template <size_t VALUE_SIZE>
+        ExtractColumnKernel<VALUE_SIZE> selectExtractColumnKernel() noexcept
+        {
+#if defined(RESTOOLS_X86)
+            if (cpuSupportsAvx2()) {
+                return &extractColumnAvx2<VALUE_SIZE>;
+            }
+#endif
+            return &extractColumnPortable<VALUE_SIZE>;
+        }
+
+        // srcBytesSize bounds the gathers which read past a narrow field
+        template <size_t VALUE_SIZE>
+        inline void extractColumn(const unsigned char* srcBytes, size_t srcBytesSize, size_t recordSize, size_t count,
+            const record_column& column, size_t firstRecord) noexcept
+        {
+            static const ExtractColumnKernel<VALUE_SIZE> kernel = selectExtractColumnKernel<VALUE_SIZE>();
+
+            constexpr size_t gatherSize = VALUE_SIZE < 4 ? 4 : VALUE_SIZE;
+            const size_t fieldBegin = firstRecord * recordSize + column.offset;
+            // records whose gatherSize bytes at the field are inside srcBytes
+            const size_t readableCount = srcBytesSize < fieldBegin + gatherSize ? 0 :
+                std::min(count, (srcBytesSize - fieldBegin - gatherSize) / recordSize + 1);
+            // gather indexes are 32-bit
+            const size_t gatheredCount = recordSize <= (size_t(1) << 27) ? readableCount : 0;
+
+            const bool needsReverse = ((std::endian::native == std::endian::little && column.isBigEndian) ||
+                (std::endian::native == std::endian::big && !column.isBigEndian));
+
+            kernel(srcBytes + fieldBegin, recordSize, count, gatheredCount, column.dstBytes + firstRecord * VALUE_SIZE, needsReverse);
+        }
+    }
+
+    // Splits count records of recordSize bytes into columns: the field at columns[i].offset of every record is
+    // converted with its endianness and written to columns[i].dstBytes. Records are processed in L1-sized tiles,
+    // every column of a tile is filled before the next one is read. With AVX2 fields are gathered from
+    // several records at once and byte reversed with a shuffle.
+    inline void bytesToColumnsFast(const unsigned char* srcBytes, size_t srcBytesSize, size_t recordSize, size_t count,
+        const record_column* columns, size_t columnsCount) noexcept
+    {
+        if (recordSize == 0) {
+            return;
+        }
+
+        const size_t tileCount = std::max<size_t>(8, detail::COLUMNS_TILE_SIZE / recordSize);
+
+        for (size_t firstRecord = 0; firstRecord < count; firstRecord += tileCount) {
+            const size_t recordsCount = std::min(tileCount, count - firstRecord);
+
+            for (size_t i = 0; i < columnsCount; ++i) {
+                switch (columns[i].size) {
+                case 1:
+                    detail::extractColumn<1>(srcBytes, srcBytesSize, recordSize, recordsCount, columns[i], firstRecord);
+                    break;
+                case 2:
+                    detail::extractColumn<2>(srcBytes, srcBytesSize, recordSize, recordsCount, columns[i], firstRecord);
+                    break;
+                case 4:
+                    detail::extractColumn<4>(srcBytes, srcBytesSize, recordSize, recordsCount, columns[i], firstRecord);
+                    break;
+                default:
+                    detail::extractColumn<8>(srcBytes, srcBytesSize, recordSize, recordsCount, columns[i], firstRecord);
+                    break;
+                }
+            }
+        }
+    }
+
+    // Returns BufferIsOverflow when srcBytes holds less than count records or a field does not fit its record,
+    // BufferIsOverlapping when a column overlaps srcBytes or another column
+    inline BytesToTypeStatus bytesToColumnsSafe(const unsigned char* srcBytes, size_t srcBytesSize, size_t recordSize, size_t count,
+        const record_column* columns, size_t columnsCount) noexcept
+    {
+        if (recordSize == 0 || srcBytesSize / recordSize < count) {
+            return BytesToTypeStatus::BufferIsOverflow;
+        }
+
+        for (size_t i = 0; i < columnsCount; ++i) {
+            if (columns[i].offset > recordSize || recordSize - columns[i].offset < columns[i].size) {
+                return BytesToTypeStatus::BufferIsOverflow;
+            }
+
+            const unsigned char* dstBytes = columns[i].dstBytes;
+            const size_t dstBytesSize = count * columns[i].size;
+
+            if ((srcBytes < dstBytes + dstBytesSize) && (dstBytes < srcBytes + srcBytesSize)) {
+                return BytesToTypeStatus::BufferIsOverlapping;
+            }
+
+            for (size_t j = 0; j < i; ++j) {
+                if ((columns[j].dstBytes < dstBytes + dstBytesSize) && (dstBytes < columns[j].dstBytes + count * columns[j].size)) {
+                    return BytesToTypeStatus::BufferIsOverlapping;
+                }
+            }
+        }
+
+        bytesToColumnsFast(srcBytes, srcBytesSize, recordSize, count, columns, columnsCount);
+
+        return BytesToTypeStatus::Success;
+    }
+}
@@ -1,8 +1,13 @@
 #pragma once 
 
 #include <algorithm> // reverse_copy
-#include <bit> // endian
+#include <bit> // endian, bit_cast
+#include <cstdint>
 #include <cstring> // memcpy
+#include <type_traits>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <stdlib.h> // _byteswap_*
+#endif
 
 namespace restools
 {
@@ -10,7 +15,8 @@ namespace restools
     {
         Success,
         BufferIsOverflow,
-        BufferIsOverlapping
+        BufferIsOverlapping,
+        VarintIsMalformed,
     };
 
     enum class TypeToByteStatus : short
@@ -20,14 +26,93 @@ namespace restools
         BufferIsOverlapping
     };
 
-
-    template <typename T>
-    inline void bytesToTypeFast(const unsigned char* srcBytes, T& dstValue, bool isBigEndian)
+    namespace detail
     {
-        bool needsReverse = ((std::endian::native == std::endian::little && isBigEndian) ||
-            (std::endian::native == std::endian::big && !isBigEndian));
+        template <size_t SIZE> struct UnsignedOfSize {};
+        template <> struct UnsignedOfSize<1> { using type = uint8_t; };
+        template <> struct UnsignedOfSize<2> { using type = uint16_t; };
+        template <> struct UnsignedOfSize<4> { using type = uint32_t; };
+        template <> struct UnsignedOfSize<8> { using type = uint64_t; };
+
+        // Values swapped through a single register: integers, enums and floating points of 1, 2, 4 or 8 bytes
+        template <typename T>
+        inline constexpr bool isRegisterSwappable = (std::is_arithmetic_v<T> || std::is_enum_v<T>) &&
+            (sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8);
+
+        template <typename T>
+        constexpr T byteSwap(T value) noexcept
+        {
+            static_assert(std::is_integral_v<T>, "T is not integral");
+
+            if constexpr (sizeof(T) == 1) {
+                return value;
+            }
+            else {
+#if defined(__cpp_lib_byteswap)
+                return std::byteswap(value);
+#else
+                using U = std::make_unsigned_t<T>;
+                U unsignedValue = static_cast<U>(value);
+
+#if defined(__GNUC__) || defined(__clang__)
+                if constexpr (sizeof(T) == 2) {
+                    return static_cast<T>(__builtin_bswap16(unsignedValue));
+                }
+                else if constexpr (sizeof(T) == 4) {
+                    return static_cast<T>(__builtin_bswap32(unsignedValue));
+                }
+                else if constexpr (sizeof(T) == 8) {
+                    return static_cast<T>(__builtin_bswap64(unsignedValue));
+                }
+#elif defined(_MSC_VER)
+                if (!std::is_constant_evaluated()) {
+                    if constexpr (sizeof(T) == 2) {
+                        return static_cast<T>(_byteswap_ushort(unsignedValue));
+                    }
+                    else if constexpr (sizeof(T) == 4) {
+                        return static_cast<T>(_byteswap_ulong(unsignedValue));
+                    }
+                    else if constexpr (sizeof(T) == 8) {
+                        return static_cast<T>(_byteswap_uint64(unsignedValue));
+                    }
+                }
+#endif
+                U swappedValue = 0;
+                for (size_t i = 0; i < sizeof(T); ++i) {
+                    swappedValue = static_cast<U>((swappedValue << 8) | (unsignedValue & 0xFF));
+                    unsignedValue = static_cast<U>(unsignedValue >> 8);
+                }
+                return static_cast<T>(swappedValue);
+#endif
+            }
+        }
+    }
 
-        if (needsReverse) {
+    template <std::endian SRC_ENDIAN, typename T>
+    constexpr void bytesToTypeFast(const unsigned char* srcBytes, T& dstValue) noexcept
+    {
+        static_assert(SRC_ENDIAN == std::endian::big || SRC_ENDIAN == std::endian::little, "SRC_ENDIAN is not big or little");
+
+        if constexpr (detail::isRegisterSwappable<T>) {
+            using U = typename detail::UnsignedOfSize<sizeof(T)>::type;
+            U value = 0;
+
+            if (std::is_constant_evaluated()) {
+                for (size_t i = 0; i < sizeof(T); ++i) {
+                    const size_t shift = 8 * (SRC_ENDIAN == std::endian::little ? i : sizeof(T) - 1 - i);
+                    value = static_cast<U>(value | (static_cast<U>(srcBytes[i]) << shift));
+                }
+            }
+            else {
+                std::memcpy(&value, srcBytes, sizeof(T));
+                if constexpr (SRC_ENDIAN != std::endian::native) {
+                    value = detail::byteSwap(value);
+                }
+            }
+
+            dstValue = std::bit_cast<T>(value);
+        }
+        else if constexpr (SRC_ENDIAN != std::endian::native) {
             std::reverse_copy(srcBytes,
                 srcBytes + sizeof(T),
                 reinterpret_cast<unsigned char*>(&dstValue));
@@ -39,6 +124,59 @@ namespace restools
         }
     }
 
+    template <std::endian DST_ENDIAN, typename T>
+    constexpr void typeToBytesFast(const T& srcValue, unsigned char* dstBytes) noexcept
+    {
+        static_assert(DST_ENDIAN == std::endian::big || DST_ENDIAN == std::endian::little, "DST_ENDIAN is not big or little");
+
+        if constexpr (detail::isRegisterSwappable<T>) {
+            using U = typename detail::UnsignedOfSize<sizeof(T)>::type;
+            U value = std::bit_cast<U>(srcValue);
+
+            if (std::is_constant_evaluated()) {
+                for (size_t i = 0; i < sizeof(T); ++i) {
+                    const size_t shift = 8 * (DST_ENDIAN == std::endian::little ? i : sizeof(T) - 1 - i);
+                    dstBytes[i] = static_cast<unsigned char>(value >> shift);
+                }
+            }
+            else {
+                if constexpr (DST_ENDIAN != std::endian::native) {
+                    value = detail::byteSwap(value);
+                }
+                std::memcpy(dstBytes, &value, sizeof(T));
+            }
+        }
+        else if constexpr (DST_ENDIAN != std::endian::native) {
+            const unsigned char* srcAsBytes = reinterpret_cast<const unsigned char*>(&srcValue);
+            std::reverse_copy(srcAsBytes, srcAsBytes + sizeof(T), dstBytes);
+        }
+        else {
+            std::memcpy(dstBytes, reinterpret_cast<const void*>(&srcValue), sizeof(T));
+        }
+    }
+
+    template <typename T>
+    inline void bytesToTypeFast(const unsigned char* srcBytes, T& dstValue, bool isBigEndian)
+    {
+        if (isBigEndian) {
+            bytesToTypeFast<std::endian::big>(srcBytes, dstValue);
+        }
+        else {
+            bytesToTypeFast<std::endian::little>(srcBytes, dstValue);
+        }
+    }
+
+    template <typename T>
+    inline void typeToBytesFast(const T& srcValue, unsigned char* dstBytes, bool isBigEndian)
+    {
+        if (isBigEndian) {
+            typeToBytesFast<std::endian::big>(srcValue, dstBytes);
+        }
+        else {
+            typeToBytesFast<std::endian::little>(srcValue, dstBytes);
+        }
+    }
+
     template <typename T>
     BytesToTypeStatus bytesToTypeSafe(const unsigned char* srcBytes, size_t srcBytesSize, T& dstValue, bool reverseEndian)
     {
@@ -74,19 +212,9 @@ namespace restools
             return TypeToByteStatus::BufferIsOverlapping;
         }
 
-        bool needsReverse = (
-            (std::endian::native == std::endian::little && isBigEndian) ||
-            (std::endian::native == std::endian::big && !isBigEndian)
-            );
-
-        if (needsReverse) {
-            std::reverse_copy(srcAsBytes, srcAsBytes + srcValueSize, dstBytes);
-        }
-        else {
-            std::memcpy(dstBytes, srcAsBytes, srcValueSize);
-        }
+        typeToBytesFast(srcValue, dstBytes, isBigEndian);
 
         return TypeToByteStatus::Success;
     }
 
-}
\ No newline at end of file
+}
@@ -0,0 +1,187 @@
+#pragma once
+
+#include <algorithm> // reverse_copy
+#include <bit> // endian
+#include <cstring> // memcpy
+#include <type_traits>
+
+#include "restools/bytes_to_type.hpp"
+#include "restools/cpu_features.hpp"
+
+namespace restools
+{
+    namespace detail
+    {
+        template <size_t VALUE_SIZE>
+        inline void byteSwapArrayScalar(const unsigned char* srcBytes, unsigned char* dstBytes, size_t count) noexcept
+        {
+            unsigned char value[VALUE_SIZE];
+
+            for (size_t i = 0; i < count; ++i) {
+                // through a temporary, so converting in place works
+                std::memcpy(value, srcBytes + i * VALUE_SIZE, VALUE_SIZE);
+                std::reverse_copy(value, value + VALUE_SIZE, dstBytes + i * VALUE_SIZE);
+            }
+        }
+
+#if defined(RESTOOLS_X86)
+        template <size_t VALUE_SIZE>
+        RESTOOLS_TARGET("ssse3")
+        inline __m128i byteSwapShuffleMask128() noexcept
+        {
+            static_assert(VALUE_SIZE == 2 || VALUE_SIZE == 4 || VALUE_SIZE == 8, "VALUE_SIZE is not 2, 4 or 8");
+
+            if constexpr (VALUE_SIZE == 2) {
+                return _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+            }
+            else if constexpr (VALUE_SIZE == 4) {
+                return _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+            }
+            else {
+                return _mm_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+            }
+        }
+
+        template <size_t VALUE_SIZE>
+        RESTOOLS_TARGET("ssse3")
+        void byteSwapArraySsse3(const unsigned char* srcBytes, unsigned char* dstBytes, size_t count) noexcept
+        {
+            constexpr size_t valuesPerVector = 16 / VALUE_SIZE;
+            const __m128i shuffleMask = byteSwapShuffleMask128<VALUE_SIZE>();
+
+            size_t i = 0;
+            for (; i + valuesPerVector <= count; i += valuesPerVector) {
+                const __m128i values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(srcBytes + i * VALUE_SIZE));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dstBytes + i * VALUE_SIZE), _mm_shuffle_epi8(values, shuffleMask));
+            }
+
+            byteSwapArrayScalar<VALUE_SIZE>(srcBytes + i * VALUE_SIZE, dstBytes + i * VALUE_SIZE, count - i);
+        }
+
+        template <size_t VALUE_SIZE>
+        RESTOOLS_TARGET("avx2")
+        void byteSwapArrayAvx2(const unsigned char* srcBytes, unsigned char* dstBytes, size_t count) noexcept
+        {
+            constexpr size_t valuesPerVector = 32 / VALUE_SIZE;
+            const __m128i laneShuffleMask = byteSwapShuffleMask128<VALUE_SIZE>();
+            const __m256i shuffleMask = _mm256_broadcastsi128_si256(laneShuffleMask);
+
+            size_t i = 0;
+            for (; i + 2 * valuesPerVector <= count; i += 2 * valuesPerVector) {
+                const __m256i first = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(srcBytes + i * VALUE_SIZE));
+                const __m256i second = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(srcBytes + (i + valuesPerVector) * VALUE_SIZE));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(dstBytes + i * VALUE_SIZE), _mm256_shuffle_epi8(first, shuffleMask));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(dstBytes + (i + valuesPerVector) * VALUE_SIZE), _mm256_shuffle_epi8(second, shuffleMask));
+            }
+
+            for (; i + valuesPerVector <= count; i += valuesPerVector) {
+                const __m256i values = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(srcBytes + i * VALUE_SIZE));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(dstBytes + i * VALUE_SIZE), _mm256_shuffle_epi8(values, shuffleMask));
+            }
+
+            byteSwapArrayScalar<VALUE_SIZE>(srcBytes + i * VALUE_SIZE, dstBytes + i * VALUE_SIZE, count - i);
+        }
+#endif
+
+        template <size_t VALUE_SIZE>
+        using ByteSwapArrayKernel = void (*)(const unsigned char*, unsigned char*, size_t);
+
+        template <size_t VALUE_SIZE>
+        ByteSwapArrayKernel<VALUE_SIZE> selectByteSwapArrayKernel() noexcept
+        {
+#if defined(RESTOOLS_X86)
+            if constexpr (VALUE_SIZE == 2 || VALUE_SIZE == 4 || VALUE_SIZE == 8) {
+                if (cpuSupportsAvx2()) {
+                    return &byteSwapArrayAvx2<VALUE_SIZE>;
+                }
+
+                if (cpuSupportsSsse3()) {
+                    return &byteSwapArraySsse3<VALUE_SIZE>;
+                }
+            }
+#endif
+            return &byteSwapArrayScalar<VALUE_SIZE>;
+        }
+
+        template <size_t VALUE_SIZE>
+        inline void byteSwapArray(const unsigned char* srcBytes, unsigned char* dstBytes, size_t count) noexcept
+        {
+            static const ByteSwapArrayKernel<VALUE_SIZE> kernel = selectByteSwapArrayKernel<VALUE_SIZE>();
+            kernel(srcBytes, dstBytes, count);
+        }
+
+        template <size_t VALUE_SIZE>
+        inline void convertArray(const unsigned char* srcBytes, unsigned char* dstBytes, size_t count, bool isBigEndian) noexcept
+        {
+            bool needsReverse = ((std::endian::native == std::endian::little && isBigEndian) ||
+                (std::endian::native == std::endian::big && !isBigEndian));
+
+            if (needsReverse && VALUE_SIZE > 1) {
+                byteSwapArray<VALUE_SIZE>(srcBytes, dstBytes, count);
+            }
+            else if (srcBytes != dstBytes) {
+                std::memmove(dstBytes, srcBytes, count * VALUE_SIZE);
+            }
+        }
+    }
+
+    // Converts count values of srcBytes to dstValues, both may point to the same memory
+    template <typename T>
+    inline void bytesToTypeArrayFast(const unsigned char* srcBytes, size_t count, T* dstValues, bool isBigEndian)
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "T is not trivially copyable");
+
+        detail::convertArray<sizeof(T)>(srcBytes, reinterpret_cast<unsigned char*>(dstValues), count, isBigEndian);
+    }
+
+    template <typename T>
+    BytesToTypeStatus bytesToTypeArraySafe(const unsigned char* srcBytes, size_t srcBytesSize, T* dstValues, size_t count, bool isBigEndian)
+    {
+        if (count > srcBytesSize / sizeof(T)) {
+            return BytesToTypeStatus::BufferIsOverflow;
+        }
+
+        // Only the bytes which are read may not overlap, the same size bounds both ranges
+        const size_t dstValuesCapacity = count * sizeof(T);
+
+        const unsigned char* dstAsBytes = reinterpret_cast<const unsigned char*>(dstValues);
+
+        if ((srcBytes < dstAsBytes + dstValuesCapacity) && (dstAsBytes < srcBytes + dstValuesCapacity)) {
+            return BytesToTypeStatus::BufferIsOverlapping;
+        }
+
+        bytesToTypeArrayFast(srcBytes, count, dstValues, isBigEndian);
+
+        return BytesToTypeStatus::Success;
+    }
+
+    // Converts count srcValues to dstBytes, both may point to the same memory
+    template <typename T>
+    inline void typeToBytesArrayFast(const T* srcValues, size_t count, unsigned char* dstBytes, bool isBigEndian)
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "T is not trivially copyable");
+
+        detail::convertArray<sizeof(T)>(reinterpret_cast<const unsigned char*>(srcValues), dstBytes, count, isBigEndian);
+    }
+
+    template <typename T>
+    TypeToByteStatus typeToBytesArraySafe(const T* srcValues, size_t count, unsigned char* dstBytes, size_t dstBytesCapacity, bool isBigEndian)
+    {
+        if (count > dstBytesCapacity / sizeof(T)) {
+            return TypeToByteStatus::BufferIsOverflow;
+        }
+
+        // Only the bytes which are written may not overlap, the same size bounds both ranges
+        const size_t srcValuesSize = count * sizeof(T);
+
+        const unsigned char* srcAsBytes = reinterpret_cast<const unsigned char*>(srcValues);
+
+        if ((srcAsBytes < dstBytes + srcValuesSize) && (dstBytes < srcAsBytes + srcValuesSize)) {
+            return TypeToByteStatus::BufferIsOverlapping;
+        }
+
+        typeToBytesArrayFast(srcValues, count, dstBytes, isBigEndian);
+
+        return TypeToByteStatus::Success;
+    }
+}
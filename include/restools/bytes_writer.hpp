@@ -0,0 +1,163 @@
+#pragma once
+
+#include <bit> // endian
+#include <cstddef>
+#include <cstring> // memcpy
+
+#include "restools/bytes_to_type.hpp"
+#include "restools/bytes_to_type_array.hpp"
+#include "restools/varint.hpp"
+
+namespace restools
+{
+    // Cursor encoding values into a byte span. A group of fields is checked once, with require() or
+    // with a single variadic write(), and encoded with no further checks.
+    // Values are not checked for overlapping with the span.
+    class bytes_writer
+    {
+    public:
+        bytes_writer(unsigned char* data, size_t capacity) noexcept
+            : data_(data)
+            , capacity_(capacity)
+        {
+        }
+
+        TypeToByteStatus require(size_t size) const noexcept
+        {
+            return size <= capacity_ - position_ ? TypeToByteStatus::Success : TypeToByteStatus::BufferIsOverflow;
+        }
+
+        template <std::endian DST_ENDIAN, typename... T>
+        void writeFast(const T&... values) noexcept
+        {
+            (writeOneFast<DST_ENDIAN>(values), ...);
+        }
+
+        template <std::endian DST_ENDIAN, typename... T>
+        TypeToByteStatus write(const T&... values) noexcept
+        {
+            if (require((sizeof(T) + ...)) != TypeToByteStatus::Success) {
+                return TypeToByteStatus::BufferIsOverflow;
+            }
+
+            writeFast<DST_ENDIAN>(values...);
+
+            return TypeToByteStatus::Success;
+        }
+
+        template <std::endian DST_ENDIAN, typename T>
+        void writeArrayFast(const T* values, size_t count) noexcept
+        {
+            typeToBytesArrayFast(values, count, data_ + position_, DST_ENDIAN == std::endian::big);
+            position_ += count * sizeof(T);
+        }
+
+        template <std::endian DST_ENDIAN, typename T>
+        TypeToByteStatus writeArray(const T* values, size_t count) noexcept
+        {
+            if (count > (capacity_ - position_) / sizeof(T)) {
+                return TypeToByteStatus::BufferIsOverflow;
+            }
+
+            writeArrayFast<DST_ENDIAN>(values, count);
+
+            return TypeToByteStatus::Success;
+        }
+
+        template <typename T>
+        TypeToByteStatus writeVarint(T value) noexcept
+        {
+            size_t writtenSize = 0;
+            const TypeToByteStatus status = varintToBytesSafe(value, data_ + position_, capacity_ - position_, writtenSize);
+
+            if (status == TypeToByteStatus::Success) {
+                position_ += writtenSize;
+            }
+
+            return status;
+        }
+
+        template <typename T>
+        TypeToByteStatus writeVarintArray(const T* values, size_t count) noexcept
+        {
+            size_t writtenSize = 0;
+            const TypeToByteStatus status = varintToBytesArraySafe(values, count, data_ + position_, capacity_ - position_, writtenSize);
+
+            if (status == TypeToByteStatus::Success) {
+                position_ += writtenSize;
+            }
+
+            return status;
+        }
+
+        void writeBytesFast(const unsigned char* bytes, size_t size) noexcept
+        {
+            std::memcpy(data_ + position_, bytes, size);
+            position_ += size;
+        }
+
+        TypeToByteStatus writeBytes(const unsigned char* bytes, size_t size) noexcept
+        {
+            if (require(size) != TypeToByteStatus::Success) {
+                return TypeToByteStatus::BufferIsOverflow;
+            }
+
+            writeBytesFast(bytes, size);
+
+            return TypeToByteStatus::Success;
+        }
+
+        void skipFast(size_t size) noexcept
+        {
+            position_ += size;
+        }
+
+        TypeToByteStatus skip(size_t size) noexcept
+        {
+            if (require(size) != TypeToByteStatus::Success) {
+                return TypeToByteStatus::BufferIsOverflow;
+            }
+
+            skipFast(size);
+
+            return TypeToByteStatus::Success;
+        }
+
+        unsigned char* data() const noexcept
+        {
+            return data_;
+        }
+
+        unsigned char* current() const noexcept
+        {
+            return data_ + position_;
+        }
+
+        size_t capacity() const noexcept
+        {
+            return capacity_;
+        }
+
+        size_t position() const noexcept
+        {
+            return position_;
+        }
+
+        size_t remaining() const noexcept
+        {
+            return capacity_ - position_;
+        }
+
+    private:
+        template <std::endian DST_ENDIAN, typename T>
+        void writeOneFast(const T& value) noexcept
+        {
+            typeToBytesFast<DST_ENDIAN>(value, data_ + position_);
+            position_ += sizeof(T);
+        }
+
+        unsigned char* data_;
+        size_t capacity_;
+        size_t position_ = 0;
+    };
+}
@@ -0,0 +1,169 @@
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <vector>
+
+#include "restools/buffer_composer.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define RESTOOLS_HAS_COMPOSER_DRAIN 1
+#include <climits> // IOV_MAX
+#include <sys/uio.h>
+#endif
+
+#if defined(RESTOOLS_HAS_COMPOSER_DRAIN)
+namespace restools
+{
+    enum class ComposerDrainStatus : short
+    {
+        Success,
+        WouldBlock,
+        WriteFailed,
+    };
+
+    // Writes the data of many composers to a file descriptor with as few writev() calls as possible.
+    // add() takes the segments of a composer with composeSegments(), nothing is flattened or copied.
+    // A composer is cleared by drain() once all of its bytes are written and must not be used before.
+    // drain() advances through the segments on partial writes and returns WouldBlock when a non-blocking
+    // descriptor is full, the next drain() continues from there.
+    template <typename COMPOSER>
+    class composer_drain
+    {
+#if defined(IOV_MAX)
+        static constexpr size_t WRITE_SEGMENTS_MAX = IOV_MAX;
+#else
+        static constexpr size_t WRITE_SEGMENTS_MAX = 1024;
+#endif
+
+        struct Entry
+        {
+            COMPOSER* composer;
+            // index of the segment after the last one of the composer
+            size_t segmentsEnd;
+        };
+
+    public:
+        // Nothing is added when another status than Success is returned or std::bad_alloc is thrown
+        BufferComposerComposeStatus add(COMPOSER& composer)
+        {
+            // both vectors are grown first so that appending the segments below does not throw
+            reserveMore(iovecs_, composer.segmentsCount());
+            reserveMore(entries_, 1);
+
+            const size_t iovecsSize = iovecs_.size();
+            size_t composedDataSize = 0;
+
+            const BufferComposerComposeStatus status = composer.composeSegments([this](const unsigned char* data, size_t size)
+            {
+                iovecs_.push_back({ const_cast<unsigned char*>(data), size });
+            }, composedDataSize);
+
+            if (status != BufferComposerComposeStatus::Success) {
+                iovecs_.resize(iovecsSize);
+                return status;
+            }
+
+            entries_.push_back({ &composer, iovecs_.size() });
+            pendingSize_ += composedDataSize;
+
+            return BufferComposerComposeStatus::Success;
+        }
+
+        // writtenSize is the count of bytes written by this call, also on failure. errno is kept on WriteFailed,
+        // unless writev() wrote nothing without an error.
+        ComposerDrainStatus drain(int fd, size_t& writtenSize)
+        {
+            writtenSize = 0;
+
+            while (iovecIndex_ < iovecs_.size()) {
+                const size_t writeSegmentsCount = std::min(WRITE_SEGMENTS_MAX, iovecs_.size() - iovecIndex_);
+                const ssize_t written = writev(fd, iovecs_.data() + iovecIndex_, static_cast<int>(writeSegmentsCount));
+
+                if (written < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+
+                    if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                        return ComposerDrainStatus::WouldBlock;
+                    }
+
+                    return ComposerDrainStatus::WriteFailed;
+                }
+
+                // no progress on a non-empty batch, retrying would spin
+                if (written == 0) {
+                    return ComposerDrainStatus::WriteFailed;
+                }
+
+                writtenSize += static_cast<size_t>(written);
+                advance(static_cast<size_t>(written));
+            }
+
+            reset();
+
+            return ComposerDrainStatus::Success;
+        }
+
+        // Bytes added and not written yet
+        size_t pendingSize() const noexcept
+        {
+            return pendingSize_;
+        }
+
+        bool empty() const noexcept
+        {
+            return pendingSize_ == 0;
+        }
+
+    private:
+        void advance(size_t writtenSize) noexcept
+        {
+            pendingSize_ -= writtenSize;
+
+            while (writtenSize > 0) {
+                iovec& segment = iovecs_[iovecIndex_];
+
+                if (writtenSize < segment.iov_len) {
+                    segment.iov_base = static_cast<unsigned char*>(segment.iov_base) + writtenSize;
+                    segment.iov_len -= writtenSize;
+                    break;
+                }
+
+                writtenSize -= segment.iov_len;
+                ++iovecIndex_;
+            }
+
+            for (; entryIndex_ < entries_.size() && entries_[entryIndex_].segmentsEnd <= iovecIndex_; ++entryIndex_) {
+                entries_[entryIndex_].composer->clear();
+            }
+        }
+
+        // Geometric growth, an exact reserve() per add() would reallocate every time
+        template <typename T>
+        static void reserveMore(std::vector<T>& vector, size_t count)
+        {
+            if (vector.capacity() - vector.size() < count) {
+                vector.reserve(std::max(vector.size() + count, vector.capacity() * 2));
+            }
+        }
+
+        void reset() noexcept
+        {
+            iovecs_.clear();
+            entries_.clear();
+            iovecIndex_ = 0;
+            entryIndex_ = 0;
+            pendingSize_ = 0;
+        }
+
+        std::vector<iovec> iovecs_;
+        std::vector<Entry> entries_;
+        size_t iovecIndex_ = 0;
+        size_t entryIndex_ = 0;
+        size_t pendingSize_ = 0;
+    };
+}
+#endif
@@ -0,0 +1,582 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "restools/buffer_composer.hpp"
+
+namespace restools
+{
+    // Pool of the buffers of many composers under one byte budget, for a server which holds a composer per
+    // connection. Allocations up to BLOCK_MAX_SIZE are rounded up to a power of two and carved out of slabs,
+    // a slab serves one block size at a time and keeps its own free list. A slab whose blocks are all freed
+    // goes to a shared pool and serves any block size next, so load moving between sizes reuses it instead
+    // of growing the footprint. Larger allocations come from the heap and are freed at once.
+    // footprint() counts slabs, pooled ones included, and large allocations. An allocation which would take it
+    // over budget() first returns pooled slabs to the heap, then throws std::bad_alloc, which buffer_composer
+    // returns as MemoryBudgetIsExceeded. trim() returns pooled slabs at once.
+    // Not thread-safe, use one slab per event loop thread. It must outlive the composers which allocate from it.
+    class composer_slab
+    {
+    public:
+        static constexpr size_t BLOCK_MIN_SIZE = 64;
+        static constexpr size_t BLOCK_MAX_SIZE = 64 * 1024 /*64kb*/;
+
+        explicit composer_slab(size_t budget, size_t slabSize = 64 * 1024 /*64kb*/)
+            : budget_(budget)
+            , slabSize_(slabSize)
+        {
+        }
+
+        composer_slab(const composer_slab&) = delete;
+        composer_slab& operator=(const composer_slab&) = delete;
+
+        ~composer_slab()
+        {
+            for (const auto& [data, slab] : slabs_) {
+                ::operator delete(data, slab.size, std::align_val_t(BLOCK_MIN_SIZE));
+            }
+        }
+
+        void* allocate(size_t size)
+        {
+            if (size > BLOCK_MAX_SIZE) {
+                reserveFootprint(size);
+                void* data = ::operator new(size, std::align_val_t(BLOCK_MIN_SIZE));
+                footprint_ += size;
+                usedSize_ += size;
+                return data;
+            }
+
+            const size_t sizeClass = sizeClassOf(size);
+            const size_t blockSize = BLOCK_MIN_SIZE << sizeClass;
+            Slab* slab = partialSlabs_[sizeClass];
+
+            if (!slab) {
+                slab = takeSlab(sizeClass);
+            }
+
+            void* block = nullptr;
+            if (slab->freeList) {
+                block = slab->freeList;
+                slab->freeList = slab->freeList->next;
+            }
+            else {
+                block = slab->data + slab->carvedSize;
+                slab->carvedSize += blockSize;
+            }
+
+            ++slab->usedCount;
+            usedSize_ += blockSize;
+
+            if (isFull(*slab)) {
+                unlinkPartial(*slab);
+            }
+
+            return block;
+        }
+
+        void deallocate(void* data, size_t size) noexcept
+        {
+            if (size > BLOCK_MAX_SIZE) {
+                ::operator delete(data, size, std::align_val_t(BLOCK_MIN_SIZE));
+                footprint_ -= size;
+                usedSize_ -= size;
+                return;
+            }
+
+            Slab& slab = std::prev(slabs_.upper_bound(static_cast<unsigned char*>(data)))->second;
+            const bool wasFull = isFull(slab);
+
+            slab.freeList = ::new (data) FreeBlock{ slab.freeList };
+            --slab.usedCount;
+            usedSize_ -= BLOCK_MIN_SIZE << slab.sizeClass;
+
+            if (slab.usedCount == 0) {
+                if (!wasFull) {
+                    unlinkPartial(slab);
+                }
+                slab.freeList = nullptr;
+                slab.carvedSize = 0;
+                slab.next = pooledSlabs_;
+                pooledSlabs_ = &slab;
+                pooledSize_ += slab.size;
+            }
+            else if (wasFull) {
+                linkPartial(slab);
+            }
+        }
+
+        // Returns pooled empty slabs to the heap
+        void trim() noexcept
+        {
+            while (pooledSlabs_) {
+                Slab* slab = pooledSlabs_;
+                pooledSlabs_ = slab->next;
+                pooledSize_ -= slab->size;
+                releaseSlab(*slab);
+            }
+        }
+
+        size_t budget() const noexcept
+        {
+            return budget_;
+        }
+
+        // Bytes taken from the heap: slabs, including pooled blocks and slabs, and large allocations
+        size_t footprint() const noexcept
+        {
+            return footprint_;
+        }
+
+        // Bytes of blocks and large allocations held by composers
+        size_t usedSize() const noexcept
+        {
+            return usedSize_;
+        }
+
+        // Bytes of empty slabs kept for reuse by any block size
+        size_t pooledSize() const noexcept
+        {
+            return pooledSize_;
+        }
+
+    private:
+        static constexpr size_t SIZE_CLASSES_COUNT = std::bit_width(BLOCK_MAX_SIZE / BLOCK_MIN_SIZE);
+
+        struct FreeBlock
+        {
+            FreeBlock* next;
+        };
+
+        // A partial slab, with a free or never carved block, is linked into the list of its size class,
+        // an empty one into the pool through next
+        struct Slab
+        {
+            unsigned char* data;
+            size_t size;
+            size_t sizeClass = 0;
+            size_t usedCount = 0;
+            size_t carvedSize = 0;
+            FreeBlock* freeList = nullptr;
+            Slab* previous = nullptr;
+            Slab* next = nullptr;
+        };
+
+        static size_t sizeClassOf(size_t size) noexcept
+        {
+            return size <= BLOCK_MIN_SIZE ? 0 : static_cast<size_t>(std::bit_width((size - 1) / BLOCK_MIN_SIZE));
+        }
+
+        static bool isFull(const Slab& slab) noexcept
+        {
+            return !slab.freeList && slab.carvedSize + (BLOCK_MIN_SIZE << slab.sizeClass) > slab.size;
+        }
+
+        // A pooled slab large enough for a slab of sizeClass, or a new one
+        Slab* takeSlab(size_t sizeClass)
+        {
+            const size_t blockSize = BLOCK_MIN_SIZE << sizeClass;
+            const size_t slabSize = std::max(slabSize_, blockSize) / blockSize * blockSize;
+            Slab* slab = nullptr;
+
+            for (Slab** pooled = &pooledSlabs_; *pooled; pooled = &(*pooled)->next) {
+                if ((*pooled)->size >= slabSize) {
+                    slab = *pooled;
+                    *pooled = slab->next;
+                    pooledSize_ -= slab->size;
+                    break;
+                }
+            }
+
+            if (!slab) {
+                reserveFootprint(slabSize);
+                unsigned char* data = static_cast<unsigned char*>(::operator new(slabSize, std::align_val_t(BLOCK_MIN_SIZE)));
+                try {
+                    slab = &slabs_.try_emplace(data, Slab{ data, slabSize }).first->second;
+                }
+                catch (const std::bad_alloc&) {
+                    ::operator delete(data, slabSize, std::align_val_t(BLOCK_MIN_SIZE));
+                    throw;
+                }
+                footprint_ += slabSize;
+            }
+
+            slab->sizeClass = sizeClass;
+            linkPartial(*slab);
+
+            return slab;
+        }
+
+        void releaseSlab(const Slab& slab) noexcept
+        {
+            unsigned char* data = slab.data;
+            const size_t size = slab.size;
+            slabs_.erase(data);
+            ::operator delete(data, size, std::align_val_t(BLOCK_MIN_SIZE));
+            footprint_ -= size;
+        }
+
+        void linkPartial(Slab& slab) noexcept
+        {
+            Slab*& head = partialSlabs_[slab.sizeClass];
+            slab.previous = nullptr;
+            slab.next = head;
+            if (head) {
+                head->previous = &slab;
+            }
+            head = &slab;
+        }
+
+        void unlinkPartial(Slab& slab) noexcept
+        {
+            if (slab.previous) {
+                slab.previous->next = slab.next;
+            }
+            else {
+                partialSlabs_[slab.sizeClass] = slab.next;
+            }
+            if (slab.next) {
+                slab.next->previous = slab.previous;
+            }
+            slab.previous = nullptr;
+            slab.next = nullptr;
+        }
+
+        // Pooled slabs go back to the heap before an allocation is refused
+        void reserveFootprint(size_t size)
+        {
+            if (size > budget_ - std::min(budget_, footprint_)) {
+                trim();
+            }
+
+            if (size > budget_ - std::min(budget_, footprint_)) {
+                throw std::bad_alloc();
+            }
+        }
+
+        size_t budget_;
+        size_t slabSize_;
+        size_t footprint_ = 0;
+        size_t usedSize_ = 0;
+        size_t pooledSize_ = 0;
+        Slab* partialSlabs_[SIZE_CLASSES_COUNT] = {};
+        Slab* pooledSlabs_ = nullptr;
+        std::map<unsigned char*, Slab> slabs_;
+    };
+
+    // Allocator of a composer_slab, equal when it is the same slab. A default constructed one has no slab
+    // and allocates with std::allocator.
+    template <typename T>
+    class slab_allocator
+    {
+        static_assert(alignof(T) <= composer_slab::BLOCK_MIN_SIZE, "T is aligned over a slab block");
+
+    public:
+        using value_type = T;
+        using propagate_on_container_move_assignment = std::true_type;
+
+        slab_allocator() noexcept = default;
+
+        slab_allocator(composer_slab& slab) noexcept
+            : slab_(&slab)
+        {
+        }
+
+        template <typename U>
+        slab_allocator(const slab_allocator<U>& source) noexcept
+            : slab_(source.slab())
+        {
+        }
+
+        T* allocate(size_t count)
+        {
+            if (!slab_) {
+                return std::allocator<T>().allocate(count);
+            }
+
+            return static_cast<T*>(slab_->allocate(count * sizeof(T)));
+        }
+
+        void deallocate(T* data, size_t count) noexcept
+        {
+            if (!slab_) {
+                std::allocator<T>().deallocate(data, count);
+                return;
+            }
+
+            slab_->deallocate(data, count * sizeof(T));
+        }
+
+        composer_slab* slab() const noexcept
+        {
+            return slab_;
+        }
+
+        template <typename U>
+        bool operator==(const slab_allocator<U>& other) const noexcept
+        {
+            return slab_ == other.slab();
+        }
+
+        template <typename U>
+        bool operator!=(const slab_allocator<U>& other) const noexcept
+        {
+            return slab_ != other.slab();
+        }
+
+    private:
+        composer_slab* slab_ = nullptr;
+    };
+
+    // Composer of one connection: a small stack buffer keeps an idle composer compact, the linear buffer,
+    // chunks and chunk index are pooled blocks of the slab. cleanup() an idle composer to return them.
+    template <size_t STACK_BUFFER_MAX = 32 /*32b*/,
+        uint16_t LINEAR_BUFFER_MULTIPLIER = 2,
+        size_t CHUNK_BLOCK_SIZE = 4096 /*4kb*/,
+        typename STATISTICS = buffer_composer_no_statistics,
+        typename GROWTH_POLICY = geometric_growth<LINEAR_BUFFER_MULTIPLIER>,
+        typename CHECKSUM = buffer_composer_no_checksum>
+    using slab_buffer_composer = buffer_composer<STACK_BUFFER_MAX, LINEAR_BUFFER_MULTIPLIER, CHUNK_BLOCK_SIZE,
+        slab_allocator<unsigned char>, STATISTICS, GROWTH_POLICY, CHECKSUM>;
+
+    // Composer of one connection which takes no memory of the slab while idle: COMPOSER is constructed
+    // in a slab block by the first save or reserve and destroyed by cleanup(), clear() or a consume() or commit()
+    // which leaves nothing saved, its blocks go back to the slab then. An idle slab_composer is four words.
+    // A failed allocation of that block is returned as MemoryBudgetIsExceeded.
+    template <typename COMPOSER = slab_buffer_composer<>>
+    class slab_composer
+    {
+        static_assert(std::is_same_v<typename COMPOSER::allocator_type, slab_allocator<unsigned char>>,
+            "COMPOSER must allocate from a composer_slab");
+        static_assert(alignof(COMPOSER) <= composer_slab::BLOCK_MIN_SIZE, "COMPOSER is aligned over a slab block");
+
+    public:
+        using composer_type = COMPOSER;
+        using checksum_type = typename COMPOSER::checksum_type;
+
+        slab_composer(size_t linearBufferMaxSize, size_t saveBufferMaxCount, composer_slab& slab) noexcept
+            : slab_(&slab)
+            , linearBufferMaxSize_(linearBufferMaxSize)
+            , saveBufferMaxCount_(saveBufferMaxCount)
+        {
+        }
+
+        slab_composer(const slab_composer&) = delete;
+
+        slab_composer(slab_composer&& source) noexcept
+            : slab_(source.slab_)
+            , linearBufferMaxSize_(source.linearBufferMaxSize_)
+            , saveBufferMaxCount_(source.saveBufferMaxCount_)
+            , composer_(std::exchange(source.composer_, nullptr))
+        {
+        }
+
+        ~slab_composer()
+        {
+            cleanup();
+        }
+
+        slab_composer& operator=(const slab_composer&) = delete;
+
+        slab_composer& operator=(slab_composer&& source) noexcept
+        {
+            if (this != &source) {
+                cleanup();
+                slab_ = source.slab_;
+                linearBufferMaxSize_ = source.linearBufferMaxSize_;
+                saveBufferMaxCount_ = source.saveBufferMaxCount_;
+                composer_ = std::exchange(source.composer_, nullptr);
+            }
+
+            return *this;
+        }
+
+        BufferComposerSaveStatus save(const unsigned char* buffer, size_t bufferSize) noexcept
+        {
+            const bool isAcquired = !composer_;
+            if (!acquire()) {
+                return BufferComposerSaveStatus::MemoryBudgetIsExceeded;
+            }
+
+            return releaseIfFailed(isAcquired, composer_->save(buffer, bufferSize));
+        }
+
+        BufferComposerSaveStatus saveRef(const unsigned char* buffer, size_t bufferSize) noexcept
+        {
+            const bool isAcquired = !composer_;
+            if (!acquire()) {
+                return BufferComposerSaveStatus::MemoryBudgetIsExceeded;
+            }
+
+            return releaseIfFailed(isAcquired, composer_->saveRef(buffer, bufferSize));
+        }
+
+        BufferComposerSaveStatus reserve(size_t reserveSize, unsigned char*& reservedBuffer) noexcept
+        {
+            const bool isAcquired = !composer_;
+            if (!acquire()) {
+                return BufferComposerSaveStatus::MemoryBudgetIsExceeded;
+            }
+
+            return releaseIfFailed(isAcquired, composer_->reserve(reserveSize, reservedBuffer));
+        }
+
+        BufferComposerSaveStatus commit(size_t committedSize) noexcept
+        {
+            if (!composer_) {
+                return committedSize == 0 ? BufferComposerSaveStatus::Success : BufferComposerSaveStatus::CommitIsOverReserved;
+            }
+
+            const BufferComposerSaveStatus status = composer_->commit(committedSize);
+            if (status == BufferComposerSaveStatus::Success && composer_->savedCount() == 0) {
+                cleanup();
+            }
+
+            return status;
+        }
+
+        BufferComposerComposeStatus compose(unsigned char*& composedData, size_t& composedDataSize) noexcept
+        {
+            if (!composer_) {
+                return BufferComposerComposeStatus::NoDataSaved;
+            }
+
+            return composer_->compose(composedData, composedDataSize);
+        }
+
+        BufferComposerComposeStatus compose(unsigned char*& composedData, size_t& composedDataSize, checksum_type& checksum) noexcept
+        {
+            if (!composer_) {
+                return BufferComposerComposeStatus::NoDataSaved;
+            }
+
+            return composer_->compose(composedData, composedDataSize, checksum);
+        }
+
+        BufferComposerComposeStatus composeSegments(BufferComposerSegment* segments, size_t segmentsCapacity,
+            size_t& segmentsCount, size_t& composedDataSize) noexcept
+        {
+            if (!composer_) {
+                return BufferComposerComposeStatus::NoDataSaved;
+            }
+
+            return composer_->composeSegments(segments, segmentsCapacity, segmentsCount, composedDataSize);
+        }
+
+        template <typename FUNC>
+        BufferComposerComposeStatus composeSegments(FUNC&& onSegment, size_t& composedDataSize) noexcept
+        {
+            if (!composer_) {
+                return BufferComposerComposeStatus::NoDataSaved;
+            }
+
+            return composer_->composeSegments(std::forward<FUNC>(onSegment), composedDataSize);
+        }
+
+        size_t segmentsCount() const noexcept
+        {
+            return composer_ ? composer_->segmentsCount() : 0;
+        }
+
+        size_t savedCount() const noexcept
+        {
+            return composer_ ? composer_->savedCount() : 0;
+        }
+
+        BufferComposerSegment frontSegment() const noexcept
+        {
+            return composer_ ? composer_->frontSegment() : BufferComposerSegment();
+        }
+
+        size_t peek(size_t offset, unsigned char* dstBuffer, size_t size) const noexcept
+        {
+            return composer_ ? composer_->peek(offset, dstBuffer, size) : 0;
+        }
+
+        BufferComposerConsumeStatus consume(size_t consumedSize) noexcept
+        {
+            if (!composer_) {
+                return consumedSize == 0 ? BufferComposerConsumeStatus::Success : BufferComposerConsumeStatus::ConsumedSizeIsOverSaved;
+            }
+
+            const BufferComposerConsumeStatus status = composer_->consume(consumedSize);
+            if (status == BufferComposerConsumeStatus::Success && composer_->savedCount() == 0) {
+                cleanup();
+            }
+
+            return status;
+        }
+
+        void clear() noexcept
+        {
+            cleanup();
+        }
+
+        void cleanup() noexcept
+        {
+            if (composer_) {
+                composer_->~COMPOSER();
+                slab_->deallocate(composer_, sizeof(COMPOSER));
+                composer_ = nullptr;
+            }
+        }
+
+        // Whether the composer is not constructed, i.e. takes no memory of the slab
+        bool isIdle() const noexcept
+        {
+            return !composer_;
+        }
+
+        // The composer while it is constructed, nullptr when idle
+        COMPOSER* composer() noexcept
+        {
+            return composer_;
+        }
+
+        composer_slab& slab() const noexcept
+        {
+            return *slab_;
+        }
+
+    private:
+        bool acquire() noexcept
+        {
+            if (composer_) {
+                return true;
+            }
+
+            try {
+                void* block = slab_->allocate(sizeof(COMPOSER));
+                composer_ = ::new (block) COMPOSER(linearBufferMaxSize_, saveBufferMaxCount_, slab_allocator<unsigned char>(*slab_));
+            }
+            catch (const std::bad_alloc&) {
+                return false;
+            }
+
+            return true;
+        }
+
+        // A failed save into a composer constructed for it leaves nothing to keep
+        BufferComposerSaveStatus releaseIfFailed(bool isAcquired, BufferComposerSaveStatus status) noexcept
+        {
+            if (isAcquired && status != BufferComposerSaveStatus::Success) {
+                cleanup();
+            }
+
+            return status;
+        }
+
+        composer_slab* slab_;
+        size_t linearBufferMaxSize_;
+        size_t saveBufferMaxCount_;
+        COMPOSER* composer_ = nullptr;
+    };
+}
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <thread>
+
+#include "restools/buffer_composer.hpp"
+
+namespace restools
+{
+    // Composer for fragments of one batch produced by several threads. The buffer of saveBufferMaxCount bytes
+    // is allocated up front; save() and reserve() claim disjoint ranges with a compare-exchange of the reserved count
+    // and copy in parallel. compose() closes the batch and waits for the copies in flight to complete.
+    // A save which does not fit the rest of the buffer is refused with MaxSavedBufferCountLimited without claiming
+    // a range, a smaller one may still fit.
+    // compose() and clear() must not run concurrently with each other, clear() neither with producers.
+    template <typename ALLOCATOR = std::allocator<unsigned char>>
+    class concurrent_buffer_composer
+    {
+        static_assert(std::is_same_v<typename std::allocator_traits<ALLOCATOR>::pointer, unsigned char*>,
+            "ALLOCATOR must allocate unsigned char");
+
+        using AllocatorTraits = std::allocator_traits<ALLOCATOR>;
+
+        static constexpr size_t COMPOSED_FLAG = size_t(1) << (sizeof(size_t) * 8 - 1);
+
+    public:
+        using allocator_type = ALLOCATOR;
+
+        explicit concurrent_buffer_composer(size_t saveBufferMaxCount, const ALLOCATOR& allocator = ALLOCATOR())
+            : saveBufferMaxCount_(saveBufferMaxCount)
+            , allocator_(allocator)
+        {
+            buffer_ = AllocatorTraits::allocate(allocator_, saveBufferMaxCount_);
+        }
+
+        concurrent_buffer_composer(const concurrent_buffer_composer&) = delete;
+        concurrent_buffer_composer(concurrent_buffer_composer&&) = delete;
+        ~concurrent_buffer_composer()
+        {
+            AllocatorTraits::deallocate(allocator_, buffer_, saveBufferMaxCount_);
+        }
+
+        concurrent_buffer_composer& operator=(const concurrent_buffer_composer&) = delete;
+        concurrent_buffer_composer& operator=(concurrent_buffer_composer&&) = delete;
+
+        BufferComposerSaveStatus save(const unsigned char* buffer, size_t bufferSize) noexcept
+        {
+            if (!buffer) {
+                return BufferComposerSaveStatus::NullBuffer;
+            }
+
+            if (bufferSize == 0) {
+                return BufferComposerSaveStatus::ZeroBufferSize;
+            }
+
+            if ((buffer < buffer_ + saveBufferMaxCount_) && (buffer_ < buffer + bufferSize)) {
+                return BufferComposerSaveStatus::BufferIsOverlapping;
+            }
+
+            unsigned char* reservedBuffer = nullptr;
+            const BufferComposerSaveStatus status = reserve(bufferSize, reservedBuffer);
+            if (status != BufferComposerSaveStatus::Success) {
+                return status;
+            }
+
+            std::memcpy(reservedBuffer, buffer, bufferSize);
+            commit(bufferSize);
+
+            return BufferComposerSaveStatus::Success;
+        }
+
+        // On success the whole reservedSize must be written and passed to commit()
+        BufferComposerSaveStatus reserve(size_t reserveSize, unsigned char*& reservedBuffer) noexcept
+        {
+            if (reserveSize == 0) {
+                return BufferComposerSaveStatus::ZeroBufferSize;
+            }
+
+            if (reserveSize > saveBufferMaxCount_) {
+                return BufferComposerSaveStatus::MaxSavedBufferCountLimited;
+            }
+
+            // The reserved count never exceeds saveBufferMaxCount, so it cannot carry into COMPOSED_FLAG
+            size_t reservedOffset = reservedCount_.load(std::memory_order_relaxed);
+
+            do {
+                if (reservedOffset & COMPOSED_FLAG) {
+                    return BufferComposerSaveStatus::NotClearedAfterCompose;
+                }
+
+                if (reservedOffset > saveBufferMaxCount_ - reserveSize) {
+                    return BufferComposerSaveStatus::MaxSavedBufferCountLimited;
+                }
+            } while (!reservedCount_.compare_exchange_weak(reservedOffset, reservedOffset + reserveSize, std::memory_order_relaxed));
+
+            reservedBuffer = buffer_ + reservedOffset;
+
+            return BufferComposerSaveStatus::Success;
+        }
+
+        void commit(size_t committedSize) noexcept
+        {
+            committedCount_.fetch_add(committedSize, std::memory_order_release);
+        }
+
+        BufferComposerComposeStatus compose(unsigned char*& composedData, size_t& composedDataSize) noexcept
+        {
+            const size_t reservedCount = reservedCount_.fetch_or(COMPOSED_FLAG, std::memory_order_acq_rel);
+
+            // Ranges reserved after the flag was set are refused and never committed
+            if (!(reservedCount & COMPOSED_FLAG)) {
+                while (committedCount_.load(std::memory_order_acquire) != reservedCount) {
+                    std::this_thread::yield();
+                }
+
+                composedCount_ = reservedCount;
+            }
+
+            composedDataSize = composedCount_;
+
+            if (composedDataSize == 0) {
+                return BufferComposerComposeStatus::NoDataSaved;
+            }
+
+            composedData = buffer_;
+
+            return BufferComposerComposeStatus::Success;
+        }
+
+        void clear() noexcept
+        {
+            reservedCount_.store(0, std::memory_order_relaxed);
+            committedCount_.store(0, std::memory_order_relaxed);
+            composedCount_ = 0;
+        }
+
+        allocator_type get_allocator() const noexcept
+        {
+            return allocator_;
+        }
+
+    private:
+        size_t saveBufferMaxCount_;
+        ALLOCATOR allocator_;
+        unsigned char* buffer_ = nullptr;
+        size_t composedCount_ = 0;
+        alignas(64) std::atomic<size_t> reservedCount_ = 0;
+        alignas(64) std::atomic<size_t> committedCount_ = 0;
+    };
+}
@@ -0,0 +1,179 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring> // memcpy
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "restools/cpu_features.hpp"
+
+#if defined(RESTOOLS_X86) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define RESTOOLS_HAS_STREAMING_STORES 1
+#endif
+
+namespace restools
+{
+    // Copies with non-temporal stores which bypass the cache, for destinations too large to be read back
+    // from it. Without SSE2 it is memcpy. Stores are fenced before return, so the copy is visible to
+    // another thread synchronized afterwards.
+    inline void streamCopy(unsigned char* dst, const unsigned char* src, size_t size) noexcept
+    {
+#if defined(RESTOOLS_HAS_STREAMING_STORES)
+        const size_t headSize = std::min(size, (16 - reinterpret_cast<uintptr_t>(dst) % 16) % 16);
+        std::memcpy(dst, src, headSize);
+        dst += headSize;
+        src += headSize;
+        size -= headSize;
+
+        for (; size >= 64; size -= 64, dst += 64, src += 64) {
+            const __m128i first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+            const __m128i second = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 16));
+            const __m128i third = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 32));
+            const __m128i fourth = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 48));
+            _mm_stream_si128(reinterpret_cast<__m128i*>(dst), first);
+            _mm_stream_si128(reinterpret_cast<__m128i*>(dst + 16), second);
+            _mm_stream_si128(reinterpret_cast<__m128i*>(dst + 32), third);
+            _mm_stream_si128(reinterpret_cast<__m128i*>(dst + 48), fourth);
+        }
+
+        std::memcpy(dst, src, size);
+        _mm_sfence();
+#else
+        std::memcpy(dst, src, size);
+#endif
+    }
+
+    // Fixed pool of threads which run the parts of one job together with the calling thread,
+    // e.g. buffer_composer flattening a large composition with enableParallelCompose().
+    // run() calls of different threads are serialized, so a pool can be shared by many composers.
+    class copy_workers
+    {
+    public:
+        // threadsCount threads besides the caller of run(), 0 runs everything on the caller
+        explicit copy_workers(size_t threadsCount)
+        {
+            threads_.reserve(threadsCount);
+            for (size_t i = 0; i < threadsCount; ++i) {
+                threads_.emplace_back([this]() { work(); });
+            }
+        }
+
+        copy_workers(const copy_workers&) = delete;
+        copy_workers& operator=(const copy_workers&) = delete;
+
+        ~copy_workers()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                isStopped_ = true;
+            }
+            wakeUp_.notify_all();
+
+            for (std::thread& thread : threads_) {
+                thread.join();
+            }
+        }
+
+        // Threads taking part in run(), including the caller
+        size_t concurrency() const noexcept
+        {
+            return threads_.size() + 1;
+        }
+
+        // Calls func(part) for every part in [0, partsCount) on the pool and the calling thread,
+        // returns when all of them are done
+        template <typename FUNC>
+        void run(size_t partsCount, FUNC&& func) noexcept
+        {
+            if (partsCount == 0) {
+                return;
+            }
+
+            std::lock_guard<std::mutex> runLock(runMutex_);
+
+            Job job;
+            job.context = &func;
+            job.runPart = [](void* context, size_t part) { (*static_cast<std::remove_reference_t<FUNC>*>(context))(part); };
+            job.partsCount = partsCount;
+
+            if (!threads_.empty()) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                job_ = &job;
+                ++jobGeneration_;
+            }
+            wakeUp_.notify_all();
+
+            runParts(job);
+
+            std::unique_lock<std::mutex> lock(mutex_);
+            done_.wait(lock, [&job]() { return job.doneCount.load(std::memory_order_acquire) == job.partsCount; });
+            job_ = nullptr;
+            // workers may still be looking for parts of the job, it lives on this stack
+            done_.wait(lock, [this]() { return activeThreadsCount_ == 0; });
+        }
+
+    private:
+        struct Job
+        {
+            void* context = nullptr;
+            void (*runPart)(void*, size_t) = nullptr;
+            size_t partsCount = 0;
+            std::atomic<size_t> nextPart = 0;
+            std::atomic<size_t> doneCount = 0;
+        };
+
+        void runParts(Job& job) noexcept
+        {
+            for (size_t part = job.nextPart.fetch_add(1); part < job.partsCount; part = job.nextPart.fetch_add(1)) {
+                job.runPart(job.context, part);
+
+                if (job.doneCount.fetch_add(1, std::memory_order_acq_rel) + 1 == job.partsCount) {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    done_.notify_all();
+                }
+            }
+        }
+
+        void work() noexcept
+        {
+            size_t seenGeneration = 0;
+            std::unique_lock<std::mutex> lock(mutex_);
+
+            for (;;) {
+                wakeUp_.wait(lock, [this, &seenGeneration]() { return isStopped_ || (job_ && jobGeneration_ != seenGeneration); });
+
+                if (isStopped_) {
+                    return;
+                }
+
+                seenGeneration = jobGeneration_;
+                Job* job = job_;
+                ++activeThreadsCount_;
+                lock.unlock();
+
+                runParts(*job);
+
+                lock.lock();
+                if (--activeThreadsCount_ == 0) {
+                    done_.notify_all();
+                }
+            }
+        }
+
+        std::vector<std::thread> threads_;
+        std::mutex runMutex_;
+        std::mutex mutex_;
+        std::condition_variable wakeUp_;
+        std::condition_variable done_;
+        Job* job_ = nullptr;
+        size_t jobGeneration_ = 0;
+        size_t activeThreadsCount_ = 0;
+        bool isStopped_ = false;
+    };
+}
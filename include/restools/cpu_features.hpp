@@ -0,0 +1,91 @@
+#pragma once
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define RESTOOLS_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+#endif
+
+// Kernels using instruction sets above the compilation baseline are compiled per function
+// and only called after a runtime check below
+#if defined(RESTOOLS_X86) && (defined(__GNUC__) || defined(__clang__))
+#define RESTOOLS_TARGET(TARGET) __attribute__((target(TARGET)))
+#else
+#define RESTOOLS_TARGET(TARGET)
+#endif
+
+namespace restools
+{
+    namespace detail
+    {
+#if defined(RESTOOLS_X86)
+        struct CpuFeatures
+        {
+            bool ssse3 = false;
+            bool sse42 = false;
+            bool avx2 = false;
+        };
+
+        inline CpuFeatures detectCpuFeatures() noexcept
+        {
+            CpuFeatures features;
+#if defined(_MSC_VER) && !defined(__clang__)
+            int registers[4] = { 0 };
+            __cpuid(registers, 0);
+            const int maxLeaf = registers[0];
+
+            __cpuid(registers, 1);
+            features.ssse3 = (registers[2] & (1 << 9)) != 0;
+            features.sse42 = (registers[2] & (1 << 20)) != 0;
+            const bool osSavesYmm = (registers[2] & (1 << 27)) != 0 && (_xgetbv(0) & 0x6) == 0x6;
+
+            if (maxLeaf >= 7 && osSavesYmm) {
+                __cpuidex(registers, 7, 0);
+                features.avx2 = (registers[1] & (1 << 5)) != 0;
+            }
+#else
+            __builtin_cpu_init();
+            features.ssse3 = __builtin_cpu_supports("ssse3");
+            features.sse42 = __builtin_cpu_supports("sse4.2");
+            features.avx2 = __builtin_cpu_supports("avx2");
+#endif
+            return features;
+        }
+
+        inline const CpuFeatures& cpuFeatures() noexcept
+        {
+            static const CpuFeatures features = detectCpuFeatures();
+            return features;
+        }
+#endif
+    }
+
+    inline bool cpuSupportsSsse3() noexcept
+    {
+#if defined(RESTOOLS_X86)
+        return detail::cpuFeatures().ssse3;
+#else
+        return false;
+#endif
+    }
+
+    inline bool cpuSupportsSse42() noexcept
+    {
+#if defined(RESTOOLS_X86)
+        return detail::cpuFeatures().sse42;
+#else
+        return false;
+#endif
+    }
+
+    inline bool cpuSupportsAvx2() noexcept
+    {
+#if defined(RESTOOLS_X86)
+        return detail::cpuFeatures().avx2;
+#else
+        return false;
+#endif
+    }
+}
@@ -0,0 +1,164 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring> // memcpy
+
+#include "restools/bytes_to_type.hpp"
+#include "restools/cpu_features.hpp"
+
+namespace restools
+{
+    namespace detail
+    {
+        using Crc32cTables = std::array<std::array<uint32_t, 256>, 8>;
+
+        // Slicing-by-8 tables of the reflected Castagnoli polynomial
+        constexpr Crc32cTables makeCrc32cTables() noexcept
+        {
+            Crc32cTables tables = {};
+
+            for (uint32_t i = 0; i < 256; ++i) {
+                uint32_t crc = i;
+                for (int bit = 0; bit < 8; ++bit) {
+                    crc = (crc >> 1) ^ ((crc & 1) ? 0x82F63B78u : 0);
+                }
+                tables[0][i] = crc;
+            }
+
+            for (size_t table = 1; table < tables.size(); ++table) {
+                for (uint32_t i = 0; i < 256; ++i) {
+                    tables[table][i] = (tables[table - 1][i] >> 8) ^ tables[0][tables[table - 1][i] & 0xff];
+                }
+            }
+
+            return tables;
+        }
+
+        inline constexpr Crc32cTables CRC32C_TABLES = makeCrc32cTables();
+
+        // crc is the raw register, not inverted
+        inline uint32_t crc32cScalar(uint32_t crc, const unsigned char* data, size_t size) noexcept
+        {
+            const Crc32cTables& tables = CRC32C_TABLES;
+
+            for (; size >= 8; data += 8, size -= 8) {
+                uint32_t low = 0;
+                uint32_t high = 0;
+                bytesToTypeFast<std::endian::little>(data, low);
+                bytesToTypeFast<std::endian::little>(data + 4, high);
+                low ^= crc;
+                crc = tables[7][low & 0xff] ^ tables[6][(low >> 8) & 0xff] ^ tables[5][(low >> 16) & 0xff] ^ tables[4][low >> 24] ^
+                    tables[3][high & 0xff] ^ tables[2][(high >> 8) & 0xff] ^ tables[1][(high >> 16) & 0xff] ^ tables[0][high >> 24];
+            }
+
+            for (size_t i = 0; i < size; ++i) {
+                crc = tables[0][(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+            }
+
+            return crc;
+        }
+
+        inline uint32_t crc32cCopyScalar(uint32_t crc, unsigned char* dst, const unsigned char* src, size_t size) noexcept
+        {
+            std::memcpy(dst, src, size);
+            return crc32cScalar(crc, src, size);
+        }
+
+#if defined(RESTOOLS_X86)
+        RESTOOLS_TARGET("sse4.2")
+        inline uint32_t crc32cTailSse42(uint32_t crc, const unsigned char* data, size_t size) noexcept
+        {
+            for (size_t i = 0; i < size; ++i) {
+                crc = _mm_crc32_u8(crc, data[i]);
+            }
+            return crc;
+        }
+
+        RESTOOLS_TARGET("sse4.2")
+        inline uint32_t crc32cSse42(uint32_t crc, const unsigned char* data, size_t size) noexcept
+        {
+#if defined(__x86_64__) || defined(_M_X64)
+            uint64_t crc64 = crc;
+            for (; size >= 8; data += 8, size -= 8) {
+                uint64_t word = 0;
+                std::memcpy(&word, data, sizeof(word));
+                crc64 = _mm_crc32_u64(crc64, word);
+            }
+            crc = static_cast<uint32_t>(crc64);
+#else
+            for (; size >= 4; data += 4, size -= 4) {
+                uint32_t word = 0;
+                std::memcpy(&word, data, sizeof(word));
+                crc = _mm_crc32_u32(crc, word);
+            }
+#endif
+            return crc32cTailSse42(crc, data, size);
+        }
+
+        // Every word is checksummed from the register it is stored from, the source is read once
+        RESTOOLS_TARGET("sse4.2")
+        inline uint32_t crc32cCopySse42(uint32_t crc, unsigned char* dst, const unsigned char* src, size_t size) noexcept
+        {
+#if defined(__x86_64__) || defined(_M_X64)
+            uint64_t crc64 = crc;
+            for (; size >= 8; src += 8, dst += 8, size -= 8) {
+                uint64_t word = 0;
+                std::memcpy(&word, src, sizeof(word));
+                crc64 = _mm_crc32_u64(crc64, word);
+                std::memcpy(dst, &word, sizeof(word));
+            }
+            crc = static_cast<uint32_t>(crc64);
+#else
+            for (; size >= 4; src += 4, dst += 4, size -= 4) {
+                uint32_t word = 0;
+                std::memcpy(&word, src, sizeof(word));
+                crc = _mm_crc32_u32(crc, word);
+                std::memcpy(dst, &word, sizeof(word));
+            }
+#endif
+            std::memcpy(dst, src, size);
+            return crc32cTailSse42(crc, src, size);
+        }
+#endif
+
+        using Crc32cKernel = uint32_t (*)(uint32_t, const unsigned char*, size_t);
+        using Crc32cCopyKernel = uint32_t (*)(uint32_t, unsigned char*, const unsigned char*, size_t);
+
+        inline Crc32cKernel selectCrc32cKernel() noexcept
+        {
+#if defined(RESTOOLS_X86)
+            if (cpuSupportsSse42()) {
+                return &crc32cSse42;
+            }
+#endif
+            return &crc32cScalar;
+        }
+
+        inline Crc32cCopyKernel selectCrc32cCopyKernel() noexcept
+        {
+#if defined(RESTOOLS_X86)
+            if (cpuSupportsSse42()) {
+                return &crc32cCopySse42;
+            }
+#endif
+            return &crc32cCopyScalar;
+        }
+    }
+
+    // CRC32C (Castagnoli, as in iSCSI, ext4 and many wire formats). Passing the result of the previous call
+    // as crc continues it: crc32c(b, crc32c(a)) == crc32c(a + b).
+    inline uint32_t crc32c(const unsigned char* data, size_t size, uint32_t crc = 0) noexcept
+    {
+        static const detail::Crc32cKernel kernel = detail::selectCrc32cKernel();
+        return ~kernel(~crc, data, size);
+    }
+
+    // Copies size bytes of src to dst and continues crc over them in the same pass
+    inline uint32_t crc32cCopy(unsigned char* dst, const unsigned char* src, size_t size, uint32_t crc = 0) noexcept
+    {
+        static const detail::Crc32cCopyKernel kernel = detail::selectCrc32cCopyKernel();
+        return ~kernel(~crc, dst, src, size);
+    }
+}
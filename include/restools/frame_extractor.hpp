@@ -0,0 +1,139 @@
+#pragma once
+
+#include <bit> // endian
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "restools/buffer_composer.hpp"
+#include "restools/bytes_to_type.hpp"
+
+namespace restools
+{
+    enum class FrameExtractorStatus : short
+    {
+        Success,
+        NeedMoreData,
+        FrameIsTooLarge,
+        MemoryBudgetIsExceeded,
+        ConsumeIsFailed,
+    };
+
+    // Splits a byte stream saved into a buffer_composer into frames prefixed with a LENGTH_TYPE length header
+    // (1, 2, 4 or 8 bytes in LENGTH_ENDIAN) which counts the payload only.
+    // Stream bytes are saved through composer(), e.g. with reserve()/commit() straight from recv().
+    // next() yields the payload in place when it lies in one span of the composer, otherwise it is gathered
+    // into a scratch buffer. The yielded frame stays valid until the next call of next() which consumes it from the front.
+    // A length over frameMaxSize is refused before the scratch buffer is sized for it. When the scratch buffer
+    // cannot be allocated next() returns MemoryBudgetIsExceeded, when the yielded frame cannot be consumed
+    // (e.g. a reserve() of the composer is not committed) ConsumeIsFailed; both can be retried.
+    template <typename LENGTH_TYPE,
+        std::endian LENGTH_ENDIAN = std::endian::big,
+        typename COMPOSER = buffer_composer<>>
+    class frame_extractor
+    {
+        static_assert(std::is_unsigned_v<LENGTH_TYPE> &&
+            (sizeof(LENGTH_TYPE) == 1 || sizeof(LENGTH_TYPE) == 2 || sizeof(LENGTH_TYPE) == 4 || sizeof(LENGTH_TYPE) == 8),
+            "LENGTH_TYPE is not unsigned of 1, 2, 4 or 8 bytes");
+
+        using ScratchAllocator = typename std::allocator_traits<typename COMPOSER::allocator_type>::template rebind_alloc<unsigned char>;
+
+    public:
+        using composer_type = COMPOSER;
+
+        static constexpr size_t HEADER_SIZE = sizeof(LENGTH_TYPE);
+
+        template <typename... COMPOSER_ARGS>
+        explicit frame_extractor(size_t frameMaxSize, COMPOSER_ARGS&&... composerArgs)
+            : frameMaxSize_(frameMaxSize)
+            , composer_(std::forward<COMPOSER_ARGS>(composerArgs)...)
+            , scratchBuffer_(ScratchAllocator(composer_.get_allocator()))
+        {
+        }
+
+        COMPOSER& composer() noexcept
+        {
+            return composer_;
+        }
+
+        const COMPOSER& composer() const noexcept
+        {
+            return composer_;
+        }
+
+        FrameExtractorStatus next(const unsigned char*& frame, size_t& frameSize) noexcept
+        {
+            if (pendingConsumeSize_ > 0) {
+                if (composer_.consume(pendingConsumeSize_) != BufferComposerConsumeStatus::Success) {
+                    return FrameExtractorStatus::ConsumeIsFailed;
+                }
+                pendingConsumeSize_ = 0;
+            }
+
+            const size_t savedCount = composer_.savedCount();
+
+            if (savedCount < HEADER_SIZE) {
+                return FrameExtractorStatus::NeedMoreData;
+            }
+
+            const BufferComposerSegment front = composer_.frontSegment();
+            LENGTH_TYPE length = 0;
+
+            if (front.size >= HEADER_SIZE) {
+                bytesToTypeFast<LENGTH_ENDIAN>(front.data, length);
+            }
+            else {
+                unsigned char header[HEADER_SIZE] = {};
+                if (composer_.peek(0, header, HEADER_SIZE) != HEADER_SIZE) {
+                    return FrameExtractorStatus::NeedMoreData;
+                }
+                bytesToTypeFast<LENGTH_ENDIAN>(header, length);
+            }
+
+            if (length > frameMaxSize_ || length > scratchBuffer_.max_size()) {
+                return FrameExtractorStatus::FrameIsTooLarge;
+            }
+
+            if (savedCount - HEADER_SIZE < length) {
+                return FrameExtractorStatus::NeedMoreData;
+            }
+
+            frameSize = static_cast<size_t>(length);
+
+            if (front.size >= HEADER_SIZE + frameSize) {
+                frame = front.data + HEADER_SIZE;
+            }
+            else {
+                try {
+                    scratchBuffer_.resize(frameSize);
+                }
+                catch (const std::bad_alloc&) {
+                    return FrameExtractorStatus::MemoryBudgetIsExceeded;
+                }
+                if (composer_.peek(HEADER_SIZE, scratchBuffer_.data(), frameSize) != frameSize) {
+                    return FrameExtractorStatus::NeedMoreData;
+                }
+                frame = scratchBuffer_.data();
+            }
+
+            pendingConsumeSize_ = HEADER_SIZE + frameSize;
+
+            return FrameExtractorStatus::Success;
+        }
+
+        // Drops saved stream bytes and any yielded frame, e.g. after FrameIsTooLarge
+        void clear() noexcept
+        {
+            pendingConsumeSize_ = 0;
+            composer_.clear();
+        }
+
+    private:
+        size_t frameMaxSize_;
+        size_t pendingConsumeSize_ = 0;
+        COMPOSER composer_;
+        std::vector<unsigned char, ScratchAllocator> scratchBuffer_;
+    };
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+namespace restools
+{
+    // Growth policies of the buffer_composer linear buffer. initialSize() sizes the first allocation and
+    // nextSize() a regrowth of allocatedSize, both get requiredSize <= maxSize and return a size
+    // in [requiredSize, maxSize].
+
+    // allocatedSize * MULTIPLIER + requiredSize, the historical buffer_composer rule
+    template <uint16_t MULTIPLIER = 2>
+    struct geometric_growth
+    {
+        static_assert(MULTIPLIER > 1, "MULTIPLIER < 2");
+
+        static size_t initialSize(size_t requiredSize, size_t maxSize) noexcept
+        {
+            return std::min(maxSize, requiredSize * MULTIPLIER);
+        }
+
+        static size_t nextSize(size_t allocatedSize, size_t requiredSize, size_t maxSize) noexcept
+        {
+            return std::min(maxSize, allocatedSize * MULTIPLIER + requiredSize);
+        }
+    };
+
+    // Grows by whole INCREMENT steps, for a known bounded working set where doubling overshoots
+    template <size_t INCREMENT = 4096>
+    struct additive_growth
+    {
+        static_assert(INCREMENT > 0, "INCREMENT is zero");
+
+        static size_t initialSize(size_t requiredSize, size_t maxSize) noexcept
+        {
+            return std::min(maxSize, roundUp(requiredSize));
+        }
+
+        static size_t nextSize(size_t allocatedSize, size_t requiredSize, size_t maxSize) noexcept
+        {
+            return std::min(maxSize, roundUp(std::max(requiredSize, allocatedSize + INCREMENT)));
+        }
+
+    private:
+        static size_t roundUp(size_t size) noexcept
+        {
+            return ((size + INCREMENT - 1) / INCREMENT) * INCREMENT;
+        }
+    };
+
+    // Geometric growth rounded up to whole pages, so no allocation leaves a partial page unused
+    template <uint16_t MULTIPLIER = 2, size_t PAGE_SIZE = 4096>
+    struct page_rounded_growth
+    {
+        static_assert(MULTIPLIER > 1, "MULTIPLIER < 2");
+        static_assert(PAGE_SIZE > 0 && (PAGE_SIZE & (PAGE_SIZE - 1)) == 0, "PAGE_SIZE is not a power of 2");
+
+        static size_t initialSize(size_t requiredSize, size_t maxSize) noexcept
+        {
+            return std::min(maxSize, roundUp(requiredSize * MULTIPLIER));
+        }
+
+        static size_t nextSize(size_t allocatedSize, size_t requiredSize, size_t maxSize) noexcept
+        {
+            return std::min(maxSize, roundUp(std::max(requiredSize, allocatedSize * MULTIPLIER)));
+        }
+
+    private:
+        static size_t roundUp(size_t size) noexcept
+        {
+            return (size + PAGE_SIZE - 1) & ~(PAGE_SIZE - 1);
+        }
+    };
+
+    // Allocates linearBufferMaxSize at once and never grows, for composers which always fill it
+    struct fixed_reserve_growth
+    {
+        static size_t initialSize(size_t, size_t maxSize) noexcept
+        {
+            return maxSize;
+        }
+
+        static size_t nextSize(size_t, size_t, size_t maxSize) noexcept
+        {
+            return maxSize;
+        }
+    };
+}
@@ -0,0 +1,174 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define RESTOOLS_HAS_MAPPED_BUFFER 1
+#include <cstdlib>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace restools
+{
+    // Growable shared mapping of an unlinked file. Without a directory the file is a memfd (Linux) or
+    // a temporary file in /tmp, with a directory it is created there, so written pages are page cache
+    // which the kernel can write back and evict instead of anonymous memory of the process.
+    // Growing remaps the file, data is never copied. Not available on platforms without mmap,
+    // where reserve() always fails.
+    class mapped_buffer
+    {
+    public:
+        mapped_buffer() noexcept = default;
+
+        explicit mapped_buffer(std::string directory)
+            : directory_(std::move(directory))
+        {
+        }
+
+        mapped_buffer(const mapped_buffer&) = delete;
+        mapped_buffer(mapped_buffer&& source) noexcept
+        {
+            *this = std::move(source);
+        }
+
+        ~mapped_buffer()
+        {
+            reset();
+        }
+
+        mapped_buffer& operator=(const mapped_buffer&) = delete;
+        mapped_buffer& operator=(mapped_buffer&& source) noexcept
+        {
+            if (this != &source) {
+                reset();
+                directory_ = std::move(source.directory_);
+                data_ = std::exchange(source.data_, nullptr);
+                capacity_ = std::exchange(source.capacity_, 0);
+                fd_ = std::exchange(source.fd_, -1);
+            }
+            return *this;
+        }
+
+        // Makes at least capacity bytes addressable, keeping the mapped data. Returns false on failure,
+        // the mapping is left unchanged then.
+        bool reserve(size_t capacity) noexcept
+        {
+            if (capacity <= capacity_) {
+                return true;
+            }
+
+#if defined(RESTOOLS_HAS_MAPPED_BUFFER)
+            const size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+            capacity = ((capacity + pageSize - 1) / pageSize) * pageSize;
+
+            if (fd_ < 0 && !openFile()) {
+                return false;
+            }
+
+            if (ftruncate(fd_, static_cast<off_t>(capacity)) != 0) {
+                return false;
+            }
+
+            void* data = MAP_FAILED;
+#if defined(__linux__) && defined(MREMAP_MAYMOVE)
+            if (data_) {
+                data = mremap(data_, capacity_, capacity, MREMAP_MAYMOVE);
+            }
+            else {
+                data = mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+            }
+#else
+            data = mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+            if (data != MAP_FAILED && data_) {
+                munmap(data_, capacity_);
+            }
+#endif
+            // the old mapping stays valid on failure, the file is only longer than needed
+            if (data == MAP_FAILED) {
+                return false;
+            }
+
+            data_ = static_cast<unsigned char*>(data);
+            capacity_ = capacity;
+
+            return true;
+#else
+            return false;
+#endif
+        }
+
+        // Unmaps and closes the file, its pages are freed
+        void reset() noexcept
+        {
+#if defined(RESTOOLS_HAS_MAPPED_BUFFER)
+            if (data_) {
+                munmap(data_, capacity_);
+            }
+
+            if (fd_ >= 0) {
+                close(fd_);
+            }
+#endif
+            data_ = nullptr;
+            capacity_ = 0;
+            fd_ = -1;
+        }
+
+        unsigned char* data() const noexcept
+        {
+            return data_;
+        }
+
+        size_t capacity() const noexcept
+        {
+            return capacity_;
+        }
+
+        const std::string& directory() const noexcept
+        {
+            return directory_;
+        }
+
+    private:
+#if defined(RESTOOLS_HAS_MAPPED_BUFFER)
+        bool openFile() noexcept
+        {
+#if defined(__linux__) && defined(MFD_CLOEXEC)
+            if (directory_.empty()) {
+                fd_ = memfd_create("restools_mapped_buffer", MFD_CLOEXEC);
+                return fd_ >= 0;
+            }
+#endif
+#if defined(__linux__) && defined(O_TMPFILE)
+            if (!directory_.empty()) {
+                fd_ = open(directory_.c_str(), O_TMPFILE | O_RDWR | O_CLOEXEC, 0600);
+                if (fd_ >= 0) {
+                    return true;
+                }
+            }
+#endif
+            try {
+                std::string path = (directory_.empty() ? std::string("/tmp") : directory_) + "/restools_XXXXXX";
+                fd_ = mkstemp(path.data());
+                if (fd_ < 0) {
+                    return false;
+                }
+                unlink(path.c_str());
+                return true;
+            }
+            catch (...) {
+                return false;
+            }
+        }
+#endif
+
+        std::string directory_;
+        unsigned char* data_ = nullptr;
+        size_t capacity_ = 0;
+        int fd_ = -1;
+    };
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <type_traits>
+
+#include "restools/mapped_buffer.hpp"
+
+namespace restools
+{
+    // Allocations of at least REMAP_THRESHOLD bytes are anonymous mappings, smaller ones come from std::allocator.
+    // reallocate() of a mapping to a mapping remaps pages (mremap on Linux) instead of copying them,
+    // buffer_composer uses it to grow a huge linear buffer in place.
+    // Mappings are populated when created or grown, so their pages are faulted in one call rather than one
+    // trap per page, and the whole capacity is resident even if it is never written.
+    // Every mapping still starts from fresh zeroed pages while the heap recycles warm ones: a buffer the heap
+    // keeps (below the malloc mmap threshold, up to 32mb with glibc) grows about twice slower with remap_allocator
+    // than with std::allocator, it pays off above that, where the heap maps fresh pages as well.
+    // Without mmap every allocation comes from std::allocator.
+    template <typename T, size_t REMAP_THRESHOLD = 1024 * 1024 /*1mb*/>
+    class remap_allocator
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "T is not trivially copyable");
+
+    public:
+        using value_type = T;
+        using is_always_equal = std::true_type;
+
+        template <typename U>
+        struct rebind
+        {
+            using other = remap_allocator<U, REMAP_THRESHOLD>;
+        };
+
+        remap_allocator() noexcept = default;
+
+        template <typename U>
+        remap_allocator(const remap_allocator<U, REMAP_THRESHOLD>&) noexcept
+        {
+        }
+
+        T* allocate(size_t count)
+        {
+#if defined(RESTOOLS_HAS_MAPPED_BUFFER)
+            if (isMapped(count)) {
+                int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#if defined(MAP_POPULATE)
+                flags |= MAP_POPULATE;
+#endif
+                void* data = mmap(nullptr, mappedSize(count), PROT_READ | PROT_WRITE, flags, -1, 0);
+                if (data == MAP_FAILED) {
+                    throw std::bad_alloc();
+                }
+                return static_cast<T*>(data);
+            }
+#endif
+            return std::allocator<T>().allocate(count);
+        }
+
+        void deallocate(T* data, size_t count) noexcept
+        {
+#if defined(RESTOOLS_HAS_MAPPED_BUFFER)
+            if (isMapped(count)) {
+                munmap(data, mappedSize(count));
+                return;
+            }
+#endif
+            std::allocator<T>().deallocate(data, count);
+        }
+
+        // Moves elements [liveBegin, liveEnd) of data, allocated with count, to the same offsets of an allocation
+        // of nextCount. A remap keeps every page, a copy moves the live range only.
+        T* reallocate(T* data, size_t count, size_t liveBegin, size_t liveEnd, size_t nextCount)
+        {
+#if defined(RESTOOLS_HAS_MAPPED_BUFFER) && defined(__linux__) && defined(MREMAP_MAYMOVE)
+            if (isMapped(count) && isMapped(nextCount)) {
+                const size_t mappedCount = mappedSize(count);
+                const size_t nextMappedCount = mappedSize(nextCount);
+                void* nextData = mremap(data, mappedCount, nextMappedCount, MREMAP_MAYMOVE);
+                if (nextData == MAP_FAILED) {
+                    throw std::bad_alloc();
+                }
+#if defined(MADV_POPULATE_WRITE)
+                if (nextMappedCount > mappedCount) {
+                    madvise(static_cast<unsigned char*>(nextData) + mappedCount, nextMappedCount - mappedCount, MADV_POPULATE_WRITE);
+                }
+#endif
+                return static_cast<T*>(nextData);
+            }
+#endif
+            T* nextData = allocate(nextCount);
+            std::memcpy(nextData + liveBegin, data + liveBegin, (liveEnd - liveBegin) * sizeof(T));
+            deallocate(data, count);
+            return nextData;
+        }
+
+        template <typename U>
+        bool operator==(const remap_allocator<U, REMAP_THRESHOLD>&) const noexcept
+        {
+            return true;
+        }
+
+        template <typename U>
+        bool operator!=(const remap_allocator<U, REMAP_THRESHOLD>&) const noexcept
+        {
+            return false;
+        }
+
+    private:
+        static bool isMapped(size_t count) noexcept
+        {
+            return count * sizeof(T) >= REMAP_THRESHOLD;
+        }
+
+#if defined(RESTOOLS_HAS_MAPPED_BUFFER)
+        static size_t mappedSize(size_t count) noexcept
+        {
+            const size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+            return ((count * sizeof(T) + pageSize - 1) / pageSize) * pageSize;
+        }
+#endif
+    };
+}
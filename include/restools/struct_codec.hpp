@@ -0,0 +1,171 @@
+#pragma once
+
+#include <bit> // endian
+#include <cstddef>
+#include <type_traits>
+
+#include "restools/bytes_to_type.hpp"
+#include "restools/bytes_to_type_array.hpp"
+#include "restools/bytes_reader.hpp"
+#include "restools/bytes_writer.hpp"
+
+namespace restools
+{
+    namespace detail
+    {
+        template <typename MEMBER_POINTER>
+        struct MemberPointerTraits;
+
+        template <typename CLASS, typename MEMBER>
+        struct MemberPointerTraits<MEMBER CLASS::*>
+        {
+            using class_type = CLASS;
+            using member_type = MEMBER;
+        };
+    }
+
+    // A struct member in a packed wire layout. Arithmetic, enum members and arrays of them are supported,
+    // array elements are converted one by one with ENDIAN.
+    template <auto MEMBER, std::endian ENDIAN = std::endian::little>
+    struct struct_field
+    {
+        using class_type = typename detail::MemberPointerTraits<decltype(MEMBER)>::class_type;
+        using member_type = typename detail::MemberPointerTraits<decltype(MEMBER)>::member_type;
+        using element_type = std::remove_all_extents_t<member_type>;
+
+        static_assert(std::is_arithmetic_v<element_type> || std::is_enum_v<element_type>, "member is not arithmetic, enum or array of them");
+        static_assert(ENDIAN == std::endian::big || ENDIAN == std::endian::little, "ENDIAN is not big or little");
+
+        static constexpr size_t wireSize = sizeof(member_type);
+
+        template <typename T>
+        static constexpr bool isFieldOf = std::is_same_v<T, class_type>;
+
+        static void encodeFast(const class_type& value, unsigned char* dstBytes) noexcept
+        {
+            if constexpr (std::is_array_v<member_type>) {
+                typeToBytesArrayFast(reinterpret_cast<const element_type*>(&(value.*MEMBER)),
+                    sizeof(member_type) / sizeof(element_type), dstBytes, ENDIAN == std::endian::big);
+            }
+            else {
+                typeToBytesFast<ENDIAN>(value.*MEMBER, dstBytes);
+            }
+        }
+
+        static void decodeFast(const unsigned char* srcBytes, class_type& value) noexcept
+        {
+            if constexpr (std::is_array_v<member_type>) {
+                bytesToTypeArrayFast(srcBytes, sizeof(member_type) / sizeof(element_type),
+                    reinterpret_cast<element_type*>(&(value.*MEMBER)), ENDIAN == std::endian::big);
+            }
+            else {
+                bytesToTypeFast<ENDIAN>(srcBytes, value.*MEMBER);
+            }
+        }
+    };
+
+    // Reserved bytes in a wire layout: encoded as zeros, skipped when decoding
+    template <size_t SIZE>
+    struct struct_padding
+    {
+        static constexpr size_t wireSize = SIZE;
+
+        template <typename T>
+        static constexpr bool isFieldOf = true;
+
+        // Plain stores rather than memset: GCC checks memset against the span on paths it fails to prune
+        // after a guarded overflow, and reports -Wstringop-overflow for them
+        template <typename T>
+        static void encodeFast(const T&, unsigned char* dstBytes) noexcept
+        {
+            for (size_t i = 0; i < SIZE; ++i) {
+                dstBytes[i] = 0;
+            }
+        }
+
+        template <typename T>
+        static void decodeFast(const unsigned char*, T&) noexcept
+        {
+        }
+    };
+
+    // Declares the packed wire layout of T once as a sequence of struct_field and struct_padding,
+    // then encodes and decodes it in a single pass with one bounds check
+    template <typename T, typename... FIELDS>
+    class struct_codec
+    {
+        static_assert(sizeof...(FIELDS) > 0, "FIELDS are empty");
+        static_assert((FIELDS::template isFieldOf<T> && ...), "FIELDS are not fields of T");
+
+    public:
+        static constexpr size_t wireSize = (FIELDS::wireSize + ...);
+
+        static void encodeFast(const T& value, unsigned char* dstBytes) noexcept
+        {
+            ((FIELDS::encodeFast(value, dstBytes), dstBytes += FIELDS::wireSize), ...);
+        }
+
+        static TypeToByteStatus encode(const T& value, unsigned char* dstBytes, size_t dstBytesCapacity) noexcept
+        {
+            if (dstBytesCapacity < wireSize) {
+                return TypeToByteStatus::BufferIsOverflow;
+            }
+
+            const unsigned char* srcAsBytes = reinterpret_cast<const unsigned char*>(&value);
+
+            if ((srcAsBytes < dstBytes + dstBytesCapacity) && (dstBytes < srcAsBytes + sizeof(T))) {
+                return TypeToByteStatus::BufferIsOverlapping;
+            }
+
+            encodeFast(value, dstBytes);
+
+            return TypeToByteStatus::Success;
+        }
+
+        static TypeToByteStatus encode(const T& value, bytes_writer& writer) noexcept
+        {
+            if (writer.remaining() < wireSize) {
+                return TypeToByteStatus::BufferIsOverflow;
+            }
+
+            encodeFast(value, writer.current());
+            writer.skipFast(wireSize);
+
+            return TypeToByteStatus::Success;
+        }
+
+        static void decodeFast(const unsigned char* srcBytes, T& value) noexcept
+        {
+            ((FIELDS::decodeFast(srcBytes, value), srcBytes += FIELDS::wireSize), ...);
+        }
+
+        static BytesToTypeStatus decode(const unsigned char* srcBytes, size_t srcBytesSize, T& value) noexcept
+        {
+            if (srcBytesSize < wireSize) {
+                return BytesToTypeStatus::BufferIsOverflow;
+            }
+
+            unsigned char* dstAsBytes = reinterpret_cast<unsigned char*>(&value);
+
+            if ((srcBytes < dstAsBytes + sizeof(T)) && (dstAsBytes < srcBytes + srcBytesSize)) {
+                return BytesToTypeStatus::BufferIsOverlapping;
+            }
+
+            decodeFast(srcBytes, value);
+
+            return BytesToTypeStatus::Success;
+        }
+
+        static BytesToTypeStatus decode(bytes_reader& reader, T& value) noexcept
+        {
+            if (reader.require(wireSize) != BytesToTypeStatus::Success) {
+                return BytesToTypeStatus::BufferIsOverflow;
+            }
+
+            decodeFast(reader.current(), value);
+            reader.skipFast(wireSize);
+
+            return BytesToTypeStatus::Success;
+        }
+    };
+}
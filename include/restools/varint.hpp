@@ -0,0 +1,293 @@
+#pragma once
+
+#include <algorithm>
+#include <bit> // countr_zero, bit_width
+#include <cstdint>
+#include <cstring> // memcpy
+#include <type_traits>
+
+#include "restools/bytes_to_type.hpp"
+
+namespace restools
+{
+    // LEB128 varints as in protobuf: 7 bits per byte, least significant group first, the high bit marks
+    // a following byte. Unsigned T is encoded as is, signed T is zigzag encoded first (protobuf sint32/sint64).
+    // Decoding refuses varints longer than VARINT_MAX_SIZE<T> or with bits above T with VarintIsMalformed.
+
+    template <typename T>
+    inline constexpr size_t VARINT_MAX_SIZE = (sizeof(T) * 8 + 6) / 7;
+
+    template <typename T>
+    constexpr std::make_unsigned_t<T> zigzagEncode(T value) noexcept
+    {
+        static_assert(std::is_integral_v<T> && std::is_signed_v<T>, "T is not signed integral");
+
+        using U = std::make_unsigned_t<T>;
+        return static_cast<U>(static_cast<U>(static_cast<U>(value) << 1) ^ static_cast<U>(value >> (sizeof(T) * 8 - 1)));
+    }
+
+    template <typename T>
+    constexpr T zigzagDecode(std::make_unsigned_t<T> value) noexcept
+    {
+        static_assert(std::is_integral_v<T> && std::is_signed_v<T>, "T is not signed integral");
+
+        using U = std::make_unsigned_t<T>;
+        return static_cast<T>(static_cast<U>(value >> 1) ^ static_cast<U>(-static_cast<U>(value & 1)));
+    }
+
+    namespace detail
+    {
+        template <typename T>
+        constexpr std::make_unsigned_t<T> toVarintUnsigned(T value) noexcept
+        {
+            static_assert(std::is_integral_v<T> && !std::is_same_v<T, bool>, "T is not integral");
+
+            if constexpr (std::is_signed_v<T>) {
+                return zigzagEncode(value);
+            }
+            else {
+                return value;
+            }
+        }
+
+        template <typename T>
+        constexpr T fromVarintUnsigned(std::make_unsigned_t<T> value) noexcept
+        {
+            if constexpr (std::is_signed_v<T>) {
+                return zigzagDecode<T>(value);
+            }
+            else {
+                return value;
+            }
+        }
+
+        // Largest last byte of a varint of VARINT_MAX_SIZE<U> bytes
+        template <typename U>
+        inline constexpr unsigned VARINT_LAST_BYTE_MAX = (1u << (sizeof(U) * 8 - 7 * (VARINT_MAX_SIZE<U> - 1))) - 1;
+
+        inline constexpr uint64_t VARINT_CONTINUATION_BITS = 0x8080808080808080ull;
+
+        template <typename U>
+        BytesToTypeStatus decodeVarintScalar(const unsigned char* srcBytes, size_t srcBytesSize, U& dstValue, size_t& readSize) noexcept
+        {
+            const size_t limit = std::min(srcBytesSize, VARINT_MAX_SIZE<U>);
+            uint64_t value = 0;
+
+            for (size_t i = 0; i < limit; ++i) {
+                const unsigned char byte = srcBytes[i];
+
+                if (i == VARINT_MAX_SIZE<U> - 1 && byte > VARINT_LAST_BYTE_MAX<U>) {
+                    return BytesToTypeStatus::VarintIsMalformed;
+                }
+
+                value |= static_cast<uint64_t>(byte & 0x7f) << (7 * i);
+
+                if ((byte & 0x80) == 0) {
+                    dstValue = static_cast<U>(value);
+                    readSize = i + 1;
+                    return BytesToTypeStatus::Success;
+                }
+            }
+
+            return srcBytesSize < VARINT_MAX_SIZE<U> ? BytesToTypeStatus::BufferIsOverflow : BytesToTypeStatus::VarintIsMalformed;
+        }
+
+        inline uint64_t loadVarintWord(const unsigned char* srcBytes) noexcept
+        {
+            uint64_t word = 0;
+            bytesToTypeFast<std::endian::little>(srcBytes, word);
+            return word;
+        }
+
+        // Packs the 7-bit groups of up to 8 varint bytes of a little endian word into one value
+        inline uint64_t compactVarintWord(uint64_t word) noexcept
+        {
+            word &= 0x7f7f7f7f7f7f7f7full;
+            word = ((word & 0x7f007f007f007f00ull) >> 1) | (word & 0x007f007f007f007full);
+            word = ((word & 0x3fff00003fff0000ull) >> 2) | (word & 0x00003fff00003fffull);
+            word = ((word & 0x0fffffff00000000ull) >> 4) | (word & 0x000000000fffffffull);
+            return word;
+        }
+
+        // Decodes a varint from 8 loaded bytes, the terminating byte is found with one bit scan instead of
+        // a loop. Returns false when none of them terminates it, the caller falls back to the scalar decoder.
+        template <typename U>
+        bool decodeVarintWord(uint64_t word, U& dstValue, size_t& readSize, BytesToTypeStatus& status) noexcept
+        {
+            const uint64_t terminators = ~word & VARINT_CONTINUATION_BITS;
+
+            if (terminators == 0) {
+                return false;
+            }
+
+            const size_t size = (static_cast<size_t>(std::countr_zero(terminators)) >> 3) + 1;
+
+            if (size > VARINT_MAX_SIZE<U> ||
+                (size == VARINT_MAX_SIZE<U> && ((word >> (8 * (size - 1))) & 0xff) > VARINT_LAST_BYTE_MAX<U>)) {
+                status = BytesToTypeStatus::VarintIsMalformed;
+                return true;
+            }
+
+            dstValue = static_cast<U>(compactVarintWord(word & (~0ull >> (64 - 8 * size))));
+            readSize = size;
+            status = BytesToTypeStatus::Success;
+
+            return true;
+        }
+
+        template <typename U>
+        BytesToTypeStatus decodeVarint(const unsigned char* srcBytes, size_t srcBytesSize, U& dstValue, size_t& readSize) noexcept
+        {
+            if (srcBytesSize >= sizeof(uint64_t)) {
+                BytesToTypeStatus status = BytesToTypeStatus::Success;
+                if (decodeVarintWord(loadVarintWord(srcBytes), dstValue, readSize, status)) {
+                    return status;
+                }
+            }
+
+            return decodeVarintScalar(srcBytes, srcBytesSize, dstValue, readSize);
+        }
+    }
+
+    template <typename T>
+    constexpr size_t varintSize(T value) noexcept
+    {
+        const auto unsignedValue = detail::toVarintUnsigned(value);
+        return unsignedValue == 0 ? 1 : (static_cast<size_t>(std::bit_width(unsignedValue)) + 6) / 7;
+    }
+
+    // Writes value to dstBytes which has room for VARINT_MAX_SIZE<T> bytes, returns the written size
+    template <typename T>
+    size_t varintToBytesFast(T value, unsigned char* dstBytes) noexcept
+    {
+        std::make_unsigned_t<T> unsignedValue = detail::toVarintUnsigned(value);
+        size_t writtenSize = 0;
+
+        while (unsignedValue >= 0x80) {
+            dstBytes[writtenSize++] = static_cast<unsigned char>(unsignedValue | 0x80);
+            unsignedValue = static_cast<std::make_unsigned_t<T>>(unsignedValue >> 7);
+        }
+
+        dstBytes[writtenSize++] = static_cast<unsigned char>(unsignedValue);
+
+        return writtenSize;
+    }
+
+    template <typename T>
+    TypeToByteStatus varintToBytesSafe(T value, unsigned char* dstBytes, size_t dstBytesCapacity, size_t& writtenSize) noexcept
+    {
+        if (dstBytesCapacity < VARINT_MAX_SIZE<T> && dstBytesCapacity < varintSize(value)) {
+            return TypeToByteStatus::BufferIsOverflow;
+        }
+
+        writtenSize = varintToBytesFast(value, dstBytes);
+
+        return TypeToByteStatus::Success;
+    }
+
+    template <typename T>
+    BytesToTypeStatus bytesToVarintSafe(const unsigned char* srcBytes, size_t srcBytesSize, T& dstValue, size_t& readSize) noexcept
+    {
+        const unsigned char* dstAsBytes = reinterpret_cast<const unsigned char*>(&dstValue);
+
+        if ((srcBytes < dstAsBytes + sizeof(T)) && (dstAsBytes < srcBytes + srcBytesSize)) {
+            return BytesToTypeStatus::BufferIsOverlapping;
+        }
+
+        std::make_unsigned_t<T> unsignedValue = 0;
+        const BytesToTypeStatus status = detail::decodeVarint(srcBytes, srcBytesSize, unsignedValue, readSize);
+
+        if (status == BytesToTypeStatus::Success) {
+            dstValue = detail::fromVarintUnsigned<T>(unsignedValue);
+        }
+
+        return status;
+    }
+
+    // Encodes count values one after another, writtenSize is the size of the encoded ones on failure
+    template <typename T>
+    TypeToByteStatus varintToBytesArraySafe(const T* srcValues, size_t count, unsigned char* dstBytes, size_t dstBytesCapacity,
+        size_t& writtenSize) noexcept
+    {
+        const unsigned char* srcAsBytes = reinterpret_cast<const unsigned char*>(srcValues);
+
+        if ((srcAsBytes < dstBytes + dstBytesCapacity) && (dstBytes < srcAsBytes + count * sizeof(T))) {
+            return TypeToByteStatus::BufferIsOverlapping;
+        }
+
+        writtenSize = 0;
+
+        for (size_t i = 0; i < count; ++i) {
+            if (dstBytesCapacity - writtenSize >= VARINT_MAX_SIZE<T>) {
+                writtenSize += varintToBytesFast(srcValues[i], dstBytes + writtenSize);
+                continue;
+            }
+
+            size_t valueWrittenSize = 0;
+            if (varintToBytesSafe(srcValues[i], dstBytes + writtenSize, dstBytesCapacity - writtenSize, valueWrittenSize) !=
+                TypeToByteStatus::Success) {
+                return TypeToByteStatus::BufferIsOverflow;
+            }
+            writtenSize += valueWrittenSize;
+        }
+
+        return TypeToByteStatus::Success;
+    }
+
+    // Decodes count varints one after another, readSize is the size of the decoded ones on failure.
+    // Eight bytes are loaded at a time: a word without continuation bits yields eight one-byte varints at once,
+    // otherwise the end of the next varint is found with a bit scan.
+    template <typename T>
+    BytesToTypeStatus bytesToVarintArraySafe(const unsigned char* srcBytes, size_t srcBytesSize, T* dstValues, size_t count,
+        size_t& readSize) noexcept
+    {
+        using U = std::make_unsigned_t<T>;
+
+        const unsigned char* dstAsBytes = reinterpret_cast<const unsigned char*>(dstValues);
+
+        if ((srcBytes < dstAsBytes + count * sizeof(T)) && (dstAsBytes < srcBytes + srcBytesSize)) {
+            return BytesToTypeStatus::BufferIsOverlapping;
+        }
+
+        size_t position = 0;
+        size_t decodedCount = 0;
+
+        while (decodedCount < count) {
+            U value = 0;
+            size_t valueSize = 0;
+            BytesToTypeStatus status = BytesToTypeStatus::Success;
+
+            if (srcBytesSize - position >= sizeof(uint64_t)) {
+                const uint64_t word = detail::loadVarintWord(srcBytes + position);
+
+                if ((word & detail::VARINT_CONTINUATION_BITS) == 0 && count - decodedCount >= 8) {
+                    for (size_t i = 0; i < 8; ++i) {
+                        dstValues[decodedCount + i] = detail::fromVarintUnsigned<T>(static_cast<U>((word >> (8 * i)) & 0xff));
+                    }
+                    position += 8;
+                    decodedCount += 8;
+                    continue;
+                }
+
+                if (!detail::decodeVarintWord(word, value, valueSize, status)) {
+                    status = detail::decodeVarintScalar(srcBytes + position, srcBytesSize - position, value, valueSize);
+                }
+            }
+            else {
+                status = detail::decodeVarintScalar(srcBytes + position, srcBytesSize - position, value, valueSize);
+            }
+
+            if (status != BytesToTypeStatus::Success) {
+                readSize = position;
+                return status;
+            }
+
+            dstValues[decodedCount++] = detail::fromVarintUnsigned<T>(value);
+            position += valueSize;
+        }
+
+        readSize = position;
+
+        return BytesToTypeStatus::Success;
+    }
+}
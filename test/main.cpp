@@ -1,11 +1,31 @@
 
 extern void testBufferComposer();
+extern void testConcurrentBufferComposer();
+extern void testFrameExtractor();
+extern void testVarint();
+extern void testBitStream();
+extern void testCrc32c();
+extern void testComposerDrain();
+extern void testComposerSlab();
 extern void testBytesToType();
+extern void testBytesToTypeArray();
+extern void testBytesToColumns();
 extern void testBytesWriter();
+extern void testStructCodec();
 
 int main()
 {
     testBytesToType();
-    // testBytesWriter();
+    testBytesToTypeArray();
+    testBytesToColumns();
+    testBytesWriter();
+    testStructCodec();
     testBufferComposer();
+    testConcurrentBufferComposer();
+    testFrameExtractor();
+    testVarint();
+    testBitStream();
+    testCrc32c();
+    testComposerDrain();
+    testComposerSlab();
 }
@@ -0,0 +1,162 @@
+#include <cassert>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "restools/bit_stream.hpp"
+
+namespace
+{
+    struct BitField
+    {
+        size_t bitsCount;
+        uint64_t bits;
+    };
+
+    // One bit at a time, the definition of both orders
+    template <restools::BitOrder ORDER>
+    std::vector<unsigned char> packBitsReference(const std::vector<BitField>& fields)
+    {
+        std::vector<unsigned char> bytes;
+        size_t bitPosition = 0;
+
+        for (const BitField& field : fields) {
+            for (size_t i = 0; i < field.bitsCount; ++i) {
+                const size_t valueBit = ORDER == restools::BitOrder::MsbFirst ? field.bitsCount - 1 - i : i;
+                const size_t byteBit = ORDER == restools::BitOrder::MsbFirst ? 7 - bitPosition % 8 : bitPosition % 8;
+                if (bitPosition % 8 == 0) {
+                    bytes.push_back(0);
+                }
+                bytes.back() = static_cast<unsigned char>(bytes.back() | (((field.bits >> valueBit) & 1) << byteBit));
+                ++bitPosition;
+            }
+        }
+
+        return bytes;
+    }
+
+    template <restools::BitOrder ORDER>
+    void testBitStreamRoundTrip()
+    {
+        using namespace restools;
+
+        std::mt19937_64 generator(ORDER == BitOrder::MsbFirst ? 1 : 2);
+        std::vector<BitField> fields;
+        for (size_t i = 0; i < 5000; ++i) {
+            // mostly narrow fields, with the 0, 56, 57 and 64 bit edges
+            const size_t bitsCount = i % 97 == 0 ? 64 : i % 89 == 0 ? 57 : i % 83 == 0 ? 56 : i % 79 == 0 ? 0 : generator() % 20;
+            const uint64_t bits = bitsCount == 0 ? 0 : generator() >> (64 - bitsCount);
+            fields.push_back({ bitsCount, bits });
+        }
+
+        const std::vector<unsigned char> expected = packBitsReference<ORDER>(fields);
+
+        std::vector<unsigned char> bytes(expected.size());
+        bit_writer<ORDER> writer(bytes.data(), bytes.size());
+        for (const BitField& field : fields) {
+            assert(writer.write(field.bitsCount, field.bits) == BitWriterStatus::Success);
+        }
+        writer.flush();
+        assert(writer.writtenSize() == expected.size() && bytes == expected);
+
+        // the end of the span is read byte by byte
+        bit_reader<ORDER> reader(bytes.data(), bytes.size());
+        for (const BitField& field : fields) {
+            uint64_t bits = 0;
+            assert(reader.read(field.bitsCount, bits) == BitReaderStatus::Success && bits == field.bits);
+        }
+        assert(reader.remainingBits() < 8);
+        assert(reader.bitPosition() == writer.bitPosition());
+    }
+
+    template <restools::BitOrder ORDER>
+    void testBitStreamFields()
+    {
+        using namespace restools;
+
+        enum class Kind : uint8_t
+        {
+            First,
+            Fifth = 5,
+        };
+
+        unsigned char bytes[16] = {};
+        bit_writer<ORDER> writer(bytes, sizeof(bytes));
+
+        assert(writer.write(1, true) == BitWriterStatus::Success);
+        assert(writer.write(3, Kind::Fifth) == BitWriterStatus::Success);
+        assert(writer.write(13, uint16_t(8191)) == BitWriterStatus::Success);
+        assert(writer.write(5, int8_t(-16)) == BitWriterStatus::Success);
+        assert(writer.write(5, int8_t(15)) == BitWriterStatus::Success);
+        assert(writer.write(64, int64_t(-2)) == BitWriterStatus::Success);
+
+        assert(writer.write(3, Kind(8)) == BitWriterStatus::ValueIsOverBitsCount);
+        assert(writer.write(13, uint16_t(8192)) == BitWriterStatus::ValueIsOverBitsCount);
+        assert(writer.write(5, int8_t(16)) == BitWriterStatus::ValueIsOverBitsCount);
+        assert(writer.write(5, int8_t(-17)) == BitWriterStatus::ValueIsOverBitsCount);
+        assert(writer.write(0, uint8_t(1)) == BitWriterStatus::ValueIsOverBitsCount);
+        assert(writer.write(9, uint8_t(1)) == BitWriterStatus::BitsCountIsOverType);
+        assert(writer.write(2, false) == BitWriterStatus::BitsCountIsOverType);
+
+        // 91 bits written, 37 bits of capacity left
+        assert(writer.bitPosition() == 91);
+        assert(writer.write(38, uint64_t(0)) == BitWriterStatus::BufferIsOverflow);
+        writer.alignToByte();
+        assert(writer.bitPosition() == 96);
+        assert(writer.write(32, uint32_t(0xdeadbeef)) == BitWriterStatus::Success);
+        assert(writer.write(1, true) == BitWriterStatus::BufferIsOverflow);
+        writer.flush();
+        assert(writer.writtenSize() == 16);
+
+        bit_reader<ORDER> reader(bytes, sizeof(bytes));
+        bool flag = false;
+        Kind kind = Kind::First;
+        uint16_t counter = 0;
+        int8_t negative = 0;
+        int8_t positive = 0;
+        int64_t wide = 0;
+        uint32_t aligned = 0;
+
+        assert(reader.read(1, flag) == BitReaderStatus::Success && flag);
+        assert(reader.read(3, kind) == BitReaderStatus::Success && kind == Kind::Fifth);
+        assert(reader.read(13, counter) == BitReaderStatus::Success && counter == 8191);
+        assert(reader.read(5, negative) == BitReaderStatus::Success && negative == -16);
+        assert(reader.read(5, positive) == BitReaderStatus::Success && positive == 15);
+        assert(reader.read(64, wide) == BitReaderStatus::Success && wide == -2);
+        assert(reader.read(9, positive) == BitReaderStatus::BitsCountIsOverType);
+        reader.alignToByte();
+        assert(reader.bitPosition() == 96);
+        assert(reader.read(32, aligned) == BitReaderStatus::Success && aligned == 0xdeadbeef);
+        assert(reader.read(1, flag) == BitReaderStatus::BufferIsOverflow);
+        assert(reader.remainingBits() == 0);
+
+        bit_reader<ORDER> skippingReader(bytes, sizeof(bytes));
+        assert(skippingReader.skip(96) == BitReaderStatus::Success);
+        assert(skippingReader.read(32, aligned) == BitReaderStatus::Success && aligned == 0xdeadbeef);
+        assert(skippingReader.skip(1) == BitReaderStatus::BufferIsOverflow);
+    }
+}
+
+void testBitStream()
+{
+    using namespace restools;
+
+    testBitStreamRoundTrip<BitOrder::MsbFirst>();
+    testBitStreamRoundTrip<BitOrder::LsbFirst>();
+    testBitStreamFields<BitOrder::MsbFirst>();
+    testBitStreamFields<BitOrder::LsbFirst>();
+
+    // known layouts: 3 bits 0b101 then 5 bits 0b00011
+    const unsigned char msbFirst[] = { 0xa3 };
+    const unsigned char lsbFirst[] = { 0x1d };
+    uint8_t first = 0;
+    uint8_t second = 0;
+
+    bit_reader<BitOrder::MsbFirst> msbReader(msbFirst, 1);
+    assert(msbReader.read(3, first) == BitReaderStatus::Success && first == 5);
+    assert(msbReader.read(5, second) == BitReaderStatus::Success && second == 3);
+
+    bit_reader<BitOrder::LsbFirst> lsbReader(lsbFirst, 1);
+    assert(lsbReader.read(3, first) == BitReaderStatus::Success && first == 5);
+    assert(lsbReader.read(5, second) == BitReaderStatus::Success && second == 3);
+}
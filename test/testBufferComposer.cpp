@@ -1,8 +1,10 @@
 #include <vector>
 #include <cassert>
 #include <thread>
+#include <memory_resource>
 
 #include "restools/buffer_composer.hpp"
+#include "restools/remap_allocator.hpp"
 
 #define ASSERT_COMPOSED_BUFFER_COMPARE_RESULT(GENERATED_DATA_VEC, COMPOSED_BUFFER, COMPOSED_BUFFER_SIZE) \
     assert(GENERATED_DATA_VEC.size() == COMPOSED_BUFFER_SIZE && memcmp(GENERATED_DATA_VEC.data(), COMPOSED_BUFFER, COMPOSED_BUFFER_SIZE) == 0)
@@ -44,6 +46,18 @@ void testBufferComposerWithDataSize(size_t testDataSize, COMPOSER& composer)
             assert(status == BufferComposerSaveStatus::Success);
         }
 		
+        std::vector<BufferComposerSegment> segments(composer.segmentsCount());
+        size_t segmentsCount = 0;
+        size_t segmentedDataSize = 0;
+        BufferComposerComposeStatus segmentsStatus = composer.composeSegments(segments.data(), segments.size(), segmentsCount, segmentedDataSize);
+        assert(segmentsStatus == BufferComposerComposeStatus::Success && segmentsCount == segments.size());
+
+        std::vector<unsigned char> segmentedData;
+        for (const BufferComposerSegment& segment : segments) {
+            segmentedData.insert(segmentedData.end(), segment.data, segment.data + segment.size);
+        }
+        ASSERT_COMPOSED_BUFFER_COMPARE_RESULT(generatedData, segmentedData.data(), segmentedDataSize);
+
 		unsigned char* composedData = nullptr;
 		size_t composedDataSize = 0;
         BufferComposerComposeStatus status = composer.compose(composedData, composedDataSize);
@@ -77,7 +91,8 @@ void testBufferComposerNegative()
     assert(composer.compose(composedData,
         composedDataSize) == BufferComposerComposeStatus::Success);
 
-    assert(composer.save(generatedDataForChunks.data() + 31, 1) == BufferComposerSaveStatus::NotClearedAfterCompose);
+    assert(composer.save(generatedDataForChunks.data() + 31, 1) == BufferComposerSaveStatus::Success);
+    assert(composer.save(generatedDataForChunks.data(), 1) == BufferComposerSaveStatus::MaxSavedBufferCountLimited);
 }
 
 void testBufferComposerBufferIsOverlapping()
@@ -99,6 +114,1038 @@ void testBufferComposerBufferIsOverlapping()
     }
 }
 
+void testBufferComposerSegments()
+{
+    using namespace restools;
+    buffer_composer<8, 2> composer(16, 64);
+
+    auto generatedData = generateRandomData(40);
+    assert(composer.save(generatedData.data(), 12) == BufferComposerSaveStatus::Success);
+    assert(composer.save(generatedData.data() + 12, 10) == BufferComposerSaveStatus::Success);
+    assert(composer.save(generatedData.data() + 22, 18) == BufferComposerSaveStatus::Success);
+    assert(composer.segmentsCount() == 2);
+
+    BufferComposerSegment segments[2];
+    size_t segmentsCount = 0;
+    size_t composedDataSize = 0;
+    assert(composer.composeSegments(segments, 1, segmentsCount, composedDataSize) == BufferComposerComposeStatus::SegmentsCapacityIsNotEnough);
+    assert(segmentsCount == 2);
+
+    assert(composer.composeSegments(segments, 2, segmentsCount, composedDataSize) == BufferComposerComposeStatus::Success);
+    assert(composedDataSize == generatedData.size());
+    assert(segments[0].size == 12 && memcmp(segments[0].data, generatedData.data(), 12) == 0);
+    assert(segments[1].size == 28 && memcmp(segments[1].data, generatedData.data() + 12, 28) == 0);
+
+    std::vector<BufferComposerSegment> visitedSegments;
+    assert(composer.composeSegments([&visitedSegments](const unsigned char* data, size_t size)
+    {
+        visitedSegments.push_back({ data, size });
+    }, composedDataSize) == BufferComposerComposeStatus::Success);
+    assert(composedDataSize == generatedData.size() && visitedSegments.size() == 2);
+    assert(visitedSegments[0].data == segments[0].data && visitedSegments[1].data == segments[1].data);
+    assert(visitedSegments[1].size == segments[1].size);
+
+    assert(composer.save(generatedData.data(), 1) == BufferComposerSaveStatus::Success);
+    assert(composer.segmentsCount() == 2 && composer.savedCount() == 41);
+}
+
+void testBufferComposerChunkPacking()
+{
+    using namespace restools;
+    buffer_composer<8, 2, 64> composer(8, 1024);
+
+    auto generatedData = generateRandomData(1000);
+    size_t writtenTotal = 0;
+    for (size_t saveSize : { 8, 1, 16, 39, 100, 64, 300, 472 }) {
+        assert(composer.save(generatedData.data() + writtenTotal, saveSize) == BufferComposerSaveStatus::Success);
+        writtenTotal += saveSize;
+    }
+    assert(writtenTotal == generatedData.size());
+
+    std::vector<BufferComposerSegment> segments(composer.segmentsCount());
+    size_t segmentsCount = 0;
+    size_t composedDataSize = 0;
+    assert(composer.composeSegments(segments.data(), segments.size(), segmentsCount, composedDataSize) == BufferComposerComposeStatus::Success);
+
+    // stack prefix, then chunks of whole blocks: small saves share a block, larger saves fill the tail first
+    assert(segments[0].size == 8);
+    for (size_t i = 1; i < segments.size(); ++i) {
+        assert(reinterpret_cast<uintptr_t>(segments[i].data) % 64 == 0);
+    }
+    assert(segments.size() == 6);
+    assert(segments[1].size == 64 && segments[2].size == 128 && segments[3].size == 64);
+    assert(segments[4].size == 320 && segments[5].size == 416);
+
+    unsigned char* composedData = nullptr;
+    assert(composer.compose(composedData, composedDataSize) == BufferComposerComposeStatus::Success);
+    ASSERT_COMPOSED_BUFFER_COMPARE_RESULT(generatedData, composedData, composedDataSize);
+}
+
+void testBufferComposerReserveCommit()
+{
+    using namespace restools;
+    buffer_composer<8, 2, 64> composer(32, 256);
+
+    auto generatedData = generateRandomData(200);
+    unsigned char* reservedBuffer = nullptr;
+
+    assert(composer.commit(1) == BufferComposerSaveStatus::CommitIsOverReserved);
+    assert(composer.reserve(0, reservedBuffer) == BufferComposerSaveStatus::ZeroBufferSize);
+    assert(composer.reserve(257, reservedBuffer) == BufferComposerSaveStatus::MaxSavedBufferCountLimited);
+
+    // reservations land in the stack, linear and chunk tiers and may be committed partially
+    size_t writtenTotal = 0;
+    for (size_t reserveSize : { 4, 8, 16, 64, 100 }) {
+        assert(composer.reserve(reserveSize, reservedBuffer) == BufferComposerSaveStatus::Success);
+        assert(composer.reserve(reserveSize, reservedBuffer) == BufferComposerSaveStatus::NotCommittedAfterReserve);
+        assert(composer.save(generatedData.data(), 1) == BufferComposerSaveStatus::NotCommittedAfterReserve);
+        assert(composer.commit(reserveSize + 1) == BufferComposerSaveStatus::CommitIsOverReserved);
+
+        const size_t committedSize = reserveSize - 2;
+        std::memcpy(reservedBuffer, generatedData.data() + writtenTotal, committedSize);
+        assert(composer.commit(committedSize) == BufferComposerSaveStatus::Success);
+        writtenTotal += committedSize;
+
+        assert(composer.save(generatedData.data() + writtenTotal, 1) == BufferComposerSaveStatus::Success);
+        writtenTotal += 1;
+    }
+
+    // composeSegments() is a view and keeps the reservation, compose() and release() wait for the commit
+    unsigned char* composedData = nullptr;
+    size_t composedDataSize = 0;
+    BufferComposerSegment segments[8];
+    size_t segmentsCount = 0;
+    assert(composer.reserve(16, reservedBuffer) == BufferComposerSaveStatus::Success);
+    assert(composer.composeSegments(segments, 8, segmentsCount, composedDataSize) == BufferComposerComposeStatus::Success);
+    assert(composedDataSize == writtenTotal);
+    assert(composer.compose(composedData, composedDataSize) == BufferComposerComposeStatus::NotCommittedAfterReserve);
+    decltype(composer)::buffer_type releasedBuffer;
+    assert(composer.release(releasedBuffer) == BufferComposerComposeStatus::NotCommittedAfterReserve);
+    std::memcpy(reservedBuffer, generatedData.data() + writtenTotal, 3);
+    assert(composer.commit(3) == BufferComposerSaveStatus::Success);
+    writtenTotal += 3;
+
+    assert(composer.reserve(16, reservedBuffer) == BufferComposerSaveStatus::Success);
+    assert(composer.commit(0) == BufferComposerSaveStatus::Success);
+
+    assert(composer.compose(composedData, composedDataSize) == BufferComposerComposeStatus::Success);
+    assert(composedDataSize == writtenTotal && memcmp(composedData, generatedData.data(), writtenTotal) == 0);
+
+    // committing into the stack tier after the data moved to the linear buffer keeps it there
+    composer.clear();
+    assert(composer.reserve(24, reservedBuffer) == BufferComposerSaveStatus::Success);
+    std::memcpy(reservedBuffer, generatedData.data(), 2);
+    assert(composer.commit(2) == BufferComposerSaveStatus::Success);
+    assert(composer.save(generatedData.data() + 2, 3) == BufferComposerSaveStatus::Success);
+    assert(composer.compose(composedData, composedDataSize) == BufferComposerComposeStatus::Success);
+    assert(composedDataSize == 5 && memcmp(composedData, generatedData.data(), 5) == 0);
+}
+
+class CountingMemoryResource : public std::pmr::memory_resource
+{
+public:
+    size_t allocatedCount = 0;
+    size_t deallocatedCount = 0;
+    size_t allocatedBytes = 0;
+
+private:
+    void* do_allocate(size_t bytes, size_t alignment) override
+    {
+        ++allocatedCount;
+        allocatedBytes += bytes;
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override
+    {
+        ++deallocatedCount;
+        allocatedBytes -= bytes;
+        std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+    {
+        return this == &other;
+    }
+};
+
+void testBufferComposerMemoryResource()
+{
+    using namespace restools;
+
+    auto generatedData = generateRandomData(96);
+
+    CountingMemoryResource countingResource;
+    {
+        pmr::buffer_composer<8, 2> composer(32, 128, &countingResource);
+
+        for (size_t i = 0; i < generatedData.size(); i += 8) {
+            assert(composer.save(generatedData.data() + i, 8) == BufferComposerSaveStatus::Success);
+        }
+
+        unsigned char* composedData = nullptr;
+        size_t composedDataSize = 0;
+        assert(composer.compose(composedData, composedDataSize) == BufferComposerComposeStatus::Success);
+        ASSERT_COMPOSED_BUFFER_COMPARE_RESULT(generatedData, composedData, composedDataSize);
+
+        // linear buffer, one chunk packing all saves past the linear buffer, chunk index, composed buffer
+        assert(countingResource.allocatedCount == 4);
+    }
+    assert(countingResource.allocatedCount == countingResource.deallocatedCount);
+    assert(countingResource.allocatedBytes == 0);
+
+    unsigned char arena[4096];
+    std::pmr::monotonic_buffer_resource arenaResource(arena, sizeof(arena), std::pmr::null_memory_resource());
+    pmr::buffer_composer<8, 2, 256> composer(32, 128, &arenaResource);
+
+    for (int request = 0; request < 4; ++request) {
+        for (size_t i = 0; i < generatedData.size(); i += 8) {
+            assert(composer.save(generatedData.data() + i, 8) == BufferComposerSaveStatus::Success);
+        }
+
+        unsigned char* composedData = nullptr;
+        size_t composedDataSize = 0;
+        assert(composer.compose(composedData, composedDataSize) == BufferComposerComposeStatus::Success);
+        ASSERT_COMPOSED_BUFFER_COMPARE_RESULT(generatedData, composedData, composedDataSize);
+
+        composer.cleanup();
+        arenaResource.release();
+    }
+}
+
+template <typename COMPOSER>
+void saveGeneratedData(COMPOSER& composer, const std::vector<unsigned char>& generatedData, size_t saveSize)
+{
+    for (size_t writtenTotal = 0; writtenTotal < generatedData.size(); writtenTotal += saveSize) {
+        const size_t toWriteSize = std::min(saveSize, generatedData.size() - writtenTotal);
+        assert(composer.save(generatedData.data() + writtenTotal, toWriteSize) == restools::BufferComposerSaveStatus::Success);
+    }
+}
+
+// Settings and statistics move with the data, the target's own settings do not survive
+template <typename COMPOSER>
+void testBufferComposerMoveSettings(COMPOSER& target, COMPOSER& source)
+{
+    using namespace restools;
+
+    auto generatedData = generateRandomData(200);
+    assert(target.enableSpill(100));
+    saveGeneratedData(source, generatedData, 9);
+    const size_t savesCount = source.statistics().savesCount;
+
+    target = std::move(source);
+    assert(target.statistics().savesCount == savesCount && source.statistics().savesCount == 0);
+    assert(target.statistics().footprint > 0 && source.statistics().footprint == 0);
+    assert(target.save(generatedData.data(), 200) == BufferComposerSaveStatus::Success && !target.isSpilled());
+
+    assert(source.enableSpill(100));
+    assert(source.save(generatedData.data(), 50) == BufferComposerSaveStatus::Success);
+    target = std::move(source);
+    assert(target.save(generatedData.data(), 100) == BufferComposerSaveStatus::Success && target.isSpilled());
+    assert(source.save(generatedData.data(), 200) == BufferComposerSaveStatus::Success && !source.isSpilled());
+
+    target.cleanup();
+    source.cleanup();
+    assert(target.statistics().footprint == 0 && source.statistics().footprint == 0);
+    assert(target.statistics().allocationsCount == target.statistics().deallocationsCount);
+}
+
+void testBufferComposerMove()
+{
+    using namespace restools;
+    using composer_type = buffer_composer<8, 2, 64>;
+
+    for (size_t dataSize : { 6, 24, 200 }) {
+        auto generatedData = generateRandomData(dataSize);
+
+        std::vector<composer_type> composers;
+        for (size_t i = 0; i < 4; ++i) {
+            composers.emplace_back(32, 256);
+            saveGeneratedData(composers.back(), generatedData, 5);
+        }
+
+        composer_type moved(std::move(composers[1]));
+        composers[2] = std::move(composers[3]);
+        composers[3] = std::move(moved);
+
+        for (size_t i : { 0, 2, 3 }) {
+            unsigned char* composedData = nullptr;
+            size_t composedDataSize = 0;
+            assert(composers[i].compose(composedData, composedDataSize) == BufferComposerComposeStatus::Success);
+            ASSERT_COMPOSED_BUFFER_COMPARE_RESULT(generatedData, composedData, composedDataSize);
+        }
+
+        unsigned char* composedData = nullptr;
+        size_t composedDataSize = 0;
+        assert(composers[1].compose(composedData, composedDataSize) == BufferComposerComposeStatus::NoDataSaved);
+        saveGeneratedData(composers[1], generatedData, 7);
+        assert(composers[1].compose(composedData, composedDataSize) == BufferComposerComposeStatus::Success);
+        ASSERT_COMPOSED_BUFFER_COMPARE_RESULT(generatedData, composedData, composedDataSize);
+    }
+
+    auto generatedData = generateRandomData(200);
+    std::pmr::monotonic_buffer_resource firstResource;
+    std::pmr::monotonic_buffer_resource secondResource;
+    pmr::buffer_composer<8, 2, 64> firstComposer(32, 256, &firstResource);
+    pmr::buffer_composer<8, 2, 64> secondComposer(32, 256, &secondResource);
+    saveGeneratedData(secondComposer, generatedData, 9);
+
+    firstComposer = std::move(secondComposer);
+    assert(firstComposer.get_allocator().resource() == &firstResource);
+
+    unsigned char* composedData = nullptr;
+    size_t composedDataSize = 0;
+    assert(firstComposer.compose(composedData, composedDataSize) == BufferComposerComposeStatus::Success);
+    ASSERT_COMPOSED_BUFFER_COMPARE_RESULT(generatedData, composedData, composedDataSize);
+    assert(secondComposer.compose(composedData, composedDataSize) == BufferComposerComposeStatus::NoDataSaved);
+
+    // a copy which does not fit the storage of the target throws and keeps the source
+    pmr::buffer_composer<8, 2, 64> nullComposer(32, 256, std::pmr::null_memory_resource());
+    bool isThrown = false;
+    try {
+        nullComposer = std::move(firstComposer);
+    }
+    catch (const std::bad_alloc&) {
+        isThrown = true;
+    }
+    assert(isThrown && nullComposer.savedCount() == 0);
+    assert(firstComposer.compose(composedData, composedDataSize) == BufferComposerComposeStatus::Success);
+    ASSERT_COMPOSED_BUFFER_COMPARE_RESULT(generatedData, composedData, composedDataSize);
+
+    // equal and unequal allocators
+    {
+        using statistics_composer_type = buffer_composer<8, 2, 64, std::allocator<unsigned char>, buffer_composer_statistics>;
+        statistics_composer_type target(32, 1024);
+        statistics_composer_type source(32, 1024);
+        testBufferComposerMoveSettings(target, source);
+    }
+    {
+        using statistics_composer_type = pmr::buffer_composer<8, 2, 64, buffer_composer_statistics>;
+        statistics_composer_type target(32, 1024, &firstResource);
+        statistics_composer_type source(32, 1024, &secondResource);
+        testBufferComposerMoveSettings(target, source);
+        assert(target.get_allocator().resource() == &firstResource);
+    }
+}
+
+void testBufferComposerReleaseAdopt()
+{
+    using namespace restools;
+    buffer_composer<8, 2, 64> composer(64, 256);
+
+    for (size_t dataSize : { 6, 24, 200 }) {
+        auto generatedData = generateRandomData(dataSize);
+        saveGeneratedData(composer, generatedData, 5);
+
+        buffer_composer<8, 2, 64>::buffer_type releasedBuffer;
+        assert(composer.release(releasedBuffer) == BufferComposerComposeStatus::Success);
+        ASSERT_COMPOSED_BUFFER_COMPARE_RESULT(generatedData, releasedBuffer.data(), releasedBuffer.size());
+        assert(releasedBuffer.capacity() >= releasedBuffer.size());
+
+        unsigned char* composedData = nullptr;
+        size_t composedDataSize = 0;
+        assert(composer.compose(composedData, composedDataSize) == BufferComposerComposeStatus::NoDataSaved);
+        assert(composer.release(releasedBuffer) == BufferComposerComposeStatus::NoDataSaved);
+
+        // the released buffer outlives the composer state
+        saveGeneratedData(composer, generateRandomData(dataSize + 1), 3);
+        composer.clear();
+        ASSERT_COMPOSED_BUFFER_COMPARE_RESULT(generatedData, releasedBuffer.data(), releasedBuffer.size());
+    }
+
+    auto generatedData = generateRandomData(48);
+    saveGeneratedData(composer, generatedData, 16);
+
+    buffer_composer<8, 2, 64>::buffer_type releasedBuffer;
+    assert(composer.release(releasedBuffer) == BufferComposerComposeStatus::Success);
+    unsigned char* releasedData = releasedBuffer.data();
+
+    // the linear buffer went away with the release, adopting it back avoids a new allocation
+    assert(composer.adopt(std::move(releasedBuffer)));
+    assert(!releasedBuffer.data());
+    saveGeneratedData(composer, generatedData, 16);
+
+    unsigned char* composedData = nullptr;
+    size_t composedDataSize = 0;
+    assert(composer.compose(composedData, composedDataSize) == BufferComposerComposeStatus::Success);
+    assert(composedData == releasedData);
+    ASSERT_COMPOSED_BUFFER_COMPARE_RESULT(generatedData, composedData, composedDataSize);
+
+    std::allocator<unsigned char> allocator;
+    assert(!composer.adopt(buffer_composer<8, 2, 64>::buffer_type(allocator.allocate(16), 0, 16, allocator)));
+}
+
+void testBufferComposerConsume()
+{
+    using namespace restools;
+
+    std::vector<unsigned char> generatedData(3000);
+    for (size_t i = 0; i < generatedData.size(); ++i) {
+        generatedData[i] = static_cast<unsigned char>(i % 251);
+    }
+
+    // consume across stack, linear buffer and chunks while saving
+    for (size_t consumeStep : { 1, 7, 64, 500 }) {
+        buffer_composer<16, 2, 256> composer(128, 1 << 16);
+        size_t savedTotal = 0;
+        size_t consumedTotal = 0;
+
+        while (consumedTotal < generatedData.size()) {
+            const size_t toSaveSize = std::min<size_t>(13, generatedData.size() - savedTotal);
+            if (toSaveSize > 0) {
+                assert(composer.save(generatedData.data() + savedTotal, toSaveSize) == BufferComposerSaveStatus::Success);
+                savedTotal += toSaveSize;
+            }
+
+            assert(composer.savedCount() == savedTotal - consumedTotal);
+
+            const BufferComposerSegment frontSegment = composer.frontSegment();
+            assert(frontSegment.size > 0 && memcmp(frontSegment.data, generatedData.data() + consumedTotal, frontSegment.size) == 0);
+
+            unsigned char peeked[600];
+            const size_t peekedSize = composer.peek(0, peeked, std::min(consumeStep, composer.savedCount()));
+            assert(memcmp(peeked, generatedData.data() + consumedTotal, peekedSize) == 0);
+
+            if (composer.savedCount() >= consumeStep || savedTotal == generatedData.size()) {
+                const size_t toConsumeSize = std::min(consumeStep, composer.savedCount());
+                assert(composer.consume(toConsumeSize) == BufferComposerConsumeStatus::Success);
+                consumedTotal += toConsumeSize;
+            }
+        }
+
+        assert(composer.savedCount() == 0 && composer.segmentsCount() == 0 && composer.frontSegment().size == 0);
+    }
+
+    // the remainder stays composable after consume
+    {
+        buffer_composer<16, 2, 256> composer(64, 4096);
+        saveGeneratedData(composer, std::vector<unsigned char>(generatedData.begin(), generatedData.begin() + 1000), 10);
+        assert(composer.consume(333) == BufferComposerConsumeStatus::Success);
+
+        unsigned char peeked[10];
+        assert(composer.peek(660, peeked, sizeof(peeked)) == 7);
+        assert(memcmp(peeked, generatedData.data() + 993, 7) == 0);
+
+        unsigned char* composedBuffer = nullptr;
+        size_t composedBufferSize = 0;
+        assert(composer.compose(composedBuffer, composedBufferSize) == BufferComposerComposeStatus::Success);
+        assert(composedBufferSize == 667 && memcmp(composedBuffer, generatedData.data() + 333, 667) == 0);
+        assert(composer.consume(1) == BufferComposerConsumeStatus::Success);
+        assert(composer.compose(composedBuffer, composedBufferSize) == BufferComposerComposeStatus::Success);
+        assert(composedBufferSize == 666 && memcmp(composedBuffer, generatedData.data() + 334, 666) == 0);
+    }
+
+    // compaction keeps the stack buffer usable
+    {
+        buffer_composer<16, 2, 256> composer(64, 4096);
+        assert(composer.save(generatedData.data(), 16) == BufferComposerSaveStatus::Success);
+        assert(composer.consume(10) == BufferComposerConsumeStatus::Success);
+        assert(composer.save(generatedData.data() + 16, 10) == BufferComposerSaveStatus::Success);
+
+        unsigned char* composedBuffer = nullptr;
+        size_t composedBufferSize = 0;
+        assert(composer.compose(composedBuffer, composedBufferSize) == BufferComposerComposeStatus::Success);
+        assert(composedBufferSize == 16 && memcmp(composedBuffer, generatedData.data() + 10, 16) == 0);
+    }
+
+    // negative
+    {
+        buffer_composer<16, 2, 256> composer(64, 4096);
+        assert(composer.consume(1) == BufferComposerConsumeStatus::ConsumedSizeIsOverSaved);
+        assert(composer.save(generatedData.data(), 5) == BufferComposerSaveStatus::Success);
+        assert(composer.consume(6) == BufferComposerConsumeStatus::ConsumedSizeIsOverSaved);
+
+        unsigned char* reservedBuffer = nullptr;
+        assert(composer.reserve(5, reservedBuffer) == BufferComposerSaveStatus::Success);
+        assert(composer.consume(1) == BufferComposerConsumeStatus::NotCommittedAfterReserve);
+        assert(composer.commit(0) == BufferComposerSaveStatus::Success);
+        assert(composer.consume(5) == BufferComposerConsumeStatus::Success);
+        assert(composer.savedCount() == 0);
+    }
+}
+
+void testBufferComposerSpill()
+{
+#if defined(RESTOOLS_HAS_MAPPED_BUFFER)
+    using namespace restools;
+
+    std::vector<unsigned char> generatedData(100000);
+    for (size_t i = 0; i < generatedData.size(); ++i) {
+        generatedData[i] = static_cast<unsigned char>(i % 251);
+    }
+
+    for (const char* spillDirectory : { "", "/tmp" }) {
+        buffer_composer<16, 2, 256> composer(128, generatedData.size());
+        assert(composer.enableSpill(1000, spillDirectory));
+
+        size_t savedTotal = 0;
+        while (savedTotal < generatedData.size()) {
+            const size_t toSaveSize = std::min<size_t>(300, generatedData.size() - savedTotal);
+            assert(composer.save(generatedData.data() + savedTotal, toSaveSize) == BufferComposerSaveStatus::Success);
+            savedTotal += toSaveSize;
+            assert(composer.isSpilled() == (savedTotal > 1000));
+        }
+
+        // reserve/commit and consume inside the mapping
+        unsigned char* reservedBuffer = nullptr;
+        assert(composer.consume(10) == BufferComposerConsumeStatus::Success);
+        assert(composer.reserve(10, reservedBuffer) == BufferComposerSaveStatus::Success);
+        std::memcpy(reservedBuffer, generatedData.data(), 10);
+        assert(composer.commit(10) == BufferComposerSaveStatus::Success);
+        assert(composer.savedCount() == generatedData.size() && composer.segmentsCount() == 1);
+
+        unsigned char* composedBuffer = nullptr;
+        size_t composedBufferSize = 0;
+        assert(composer.compose(composedBuffer, composedBufferSize) == BufferComposerComposeStatus::Success);
+        assert(composedBufferSize == generatedData.size());
+        assert(memcmp(composedBuffer, generatedData.data() + 10, generatedData.size() - 10) == 0);
+        assert(memcmp(composedBuffer + generatedData.size() - 10, generatedData.data(), 10) == 0);
+
+        composer.clear();
+        assert(!composer.isSpilled());
+
+        // spilling again after clear, released data is copied out of the mapping
+        saveGeneratedData(composer, std::vector<unsigned char>(generatedData.begin(), generatedData.begin() + 5000), 700);
+        assert(composer.isSpilled());
+
+        buffer_composer<16, 2, 256>::buffer_type releasedBuffer;
+        assert(composer.release(releasedBuffer) == BufferComposerComposeStatus::Success);
+        assert(releasedBuffer.size() == 5000 && memcmp(releasedBuffer.data(), generatedData.data(), 5000) == 0);
+        assert(!composer.isSpilled() && composer.savedCount() == 0);
+
+        // moved composer keeps the mapping
+        saveGeneratedData(composer, std::vector<unsigned char>(generatedData.begin(), generatedData.begin() + 3000), 1000);
+        buffer_composer<16, 2, 256> movedComposer(std::move(composer));
+        assert(movedComposer.isSpilled() && !movedComposer.enableSpill(10));
+        assert(movedComposer.compose(composedBuffer, composedBufferSize) == BufferComposerComposeStatus::Success);
+        assert(composedBufferSize == 3000 && memcmp(composedBuffer, generatedData.data(), 3000) == 0);
+    }
+
+    // failed mapping leaves the data on the heap
+    {
+        buffer_composer<16, 2, 256> composer(128, 10000);
+        assert(composer.enableSpill(100, "/nonexistent/restools"));
+        assert(composer.save(generatedData.data(), 100) == BufferComposerSaveStatus::Success);
+        assert(composer.save(generatedData.data() + 100, 1) == BufferComposerSaveStatus::SpillIsFailed);
+        assert(!composer.isSpilled() && composer.savedCount() == 100);
+
+        assert(composer.enableSpill(0));
+        assert(composer.save(generatedData.data() + 100, 1000) == BufferComposerSaveStatus::Success);
+        assert(!composer.isSpilled() && composer.savedCount() == 1100);
+    }
+#endif
+}
+
+void testBufferComposerStatistics()
+{
+    using namespace restools;
+    using Composer = buffer_composer<16, 2, 256, std::allocator<unsigned char>, buffer_composer_statistics>;
+
+    static_assert(std::is_empty_v<buffer_composer_no_statistics>);
+
+    struct PolicyMembers
+    {
+        size_t value;
+        RESTOOLS_NO_UNIQUE_ADDRESS buffer_composer_no_statistics statistics;
+        RESTOOLS_NO_UNIQUE_ADDRESS buffer_composer_no_checksum checksum;
+    };
+    static_assert(sizeof(PolicyMembers) == sizeof(size_t), "disabled policies take space");
+
+    const std::vector<unsigned char> generatedData = generateRandomData(100);
+    Composer composer(64, 1000);
+    const buffer_composer_statistics& statistics = composer.statistics();
+
+    assert(composer.save(generatedData.data(), 10) == BufferComposerSaveStatus::Success);
+    assert(statistics.savesCount == 1 && statistics.saveSizeHistogram[3] == 1);
+    assert(statistics.copiedBytesTo(BufferComposerTier::Stack) == 10 && statistics.allocationsCount == 0);
+
+    // stack to linear buffer of 40 bytes
+    assert(composer.save(generatedData.data(), 10) == BufferComposerSaveStatus::Success);
+    assert(statistics.transitionsTo(BufferComposerTier::Linear) == 1 && statistics.allocationsCount == 1);
+    assert(statistics.copiedBytesTo(BufferComposerTier::Linear) == 20 && statistics.footprint == 40);
+
+    // linear buffer grows to 64 bytes
+    assert(composer.save(generatedData.data(), 30) == BufferComposerSaveStatus::Success);
+    assert(statistics.reallocationsCount == 1 && statistics.footprint == 64);
+    assert(statistics.copiedBytesTo(BufferComposerTier::Linear) == 70);
+
+    // chunks
+    unsigned char* reservedBuffer = nullptr;
+    assert(composer.reserve(20, reservedBuffer) == BufferComposerSaveStatus::Success);
+    std::memcpy(reservedBuffer, generatedData.data(), 20);
+    assert(composer.commit(20) == BufferComposerSaveStatus::Success);
+    assert(statistics.transitionsTo(BufferComposerTier::Chunks) == 1 && statistics.allocationsCount == 2);
+    assert(statistics.copiedBytesTo(BufferComposerTier::Chunks) == 0 && statistics.footprint == 64 + 256);
+    assert(statistics.savesCount == 4 && statistics.savedBytes == 70 && statistics.saveSizeHistogram[4] == 2);
+
+    unsigned char* composedBuffer = nullptr;
+    size_t composedBufferSize = 0;
+    assert(composer.compose(composedBuffer, composedBufferSize) == BufferComposerComposeStatus::Success);
+    assert(statistics.transitionsTo(BufferComposerTier::Composed) == 1);
+
+    // the linear buffer grows past linearBufferMaxSize to 128 bytes and only the chunk is copied after its 50 bytes
+    assert(statistics.copiedBytesTo(BufferComposerTier::Composed) == 20);
+    assert(statistics.copiedBytesTo(BufferComposerTier::Linear) == 120 && statistics.reallocationsCount == 2);
+    assert(statistics.footprint == 128 && statistics.peakFootprint == 128 + 256);
+
+    composer.cleanup();
+    assert(statistics.footprint == 0 && statistics.allocationsCount == statistics.deallocationsCount);
+
+    // aggregation of several composers
+    buffer_composer_statistics aggregated;
+    for (int i = 0; i < 3; ++i) {
+        Composer connectionComposer(64, 1000);
+        assert(connectionComposer.save(generatedData.data(), 50) == BufferComposerSaveStatus::Success);
+        aggregated.merge(connectionComposer.statistics());
+    }
+    assert(aggregated.savesCount == 3 && aggregated.saveSizeHistogram[5] == 3);
+    assert(aggregated.footprint == 3 * 64 && aggregated.peakFootprint == 64);
+
+    Composer movedComposer(std::move(composer));
+    assert(movedComposer.statistics().savesCount == 4 && composer.statistics().savesCount == 0);
+}
+
+template <typename GROWTH_POLICY, typename ALLOCATOR = std::allocator<unsigned char>>
+void testBufferComposerGrowthPolicyAllocatedSizes(size_t linearBufferMaxSize, size_t saveSize,
+    const std::vector<size_t>& expectedAllocatedSizes)
+{
+    using namespace restools;
+    using Composer = buffer_composer<16, 2, 256, ALLOCATOR, buffer_composer_statistics, GROWTH_POLICY>;
+
+    std::vector<unsigned char> generatedData(linearBufferMaxSize);
+    for (size_t i = 0; i < generatedData.size(); ++i) {
+        generatedData[i] = static_cast<unsigned char>(i % 251);
+    }
+
+    Composer composer(linearBufferMaxSize, linearBufferMaxSize);
+    std::vector<size_t> allocatedSizes;
+
+    for (size_t savedTotal = 0; savedTotal < generatedData.size(); savedTotal += saveSize) {
+        const size_t toSaveSize = std::min(saveSize, generatedData.size() - savedTotal);
+        assert(composer.save(generatedData.data() + savedTotal, toSaveSize) == BufferComposerSaveStatus::Success);
+        if (allocatedSizes.empty() ? composer.statistics().footprint > 0 : composer.statistics().footprint != allocatedSizes.back()) {
+            allocatedSizes.push_back(composer.statistics().footprint);
+        }
+    }
+
+    assert(allocatedSizes == expectedAllocatedSizes);
+
+    unsigned char* composedBuffer = nullptr;
+    size_t composedBufferSize = 0;
+    assert(composer.compose(composedBuffer, composedBufferSize) == BufferComposerComposeStatus::Success);
+    ASSERT_COMPOSED_BUFFER_COMPARE_RESULT(generatedData, composedBuffer, composedBufferSize);
+}
+
+void testBufferComposerGrowthPolicy()
+{
+    using namespace restools;
+
+    testBufferComposerGrowthPolicyAllocatedSizes<geometric_growth<2>>(1000, 100, { 200, 700, 1000 });
+    testBufferComposerGrowthPolicyAllocatedSizes<geometric_growth<4>>(1000, 100, { 400, 1000 });
+    testBufferComposerGrowthPolicyAllocatedSizes<additive_growth<300>>(1000, 100, { 300, 600, 900, 1000 });
+    testBufferComposerGrowthPolicyAllocatedSizes<page_rounded_growth<2, 256>>(2000, 100, { 256, 512, 1024, 2000 });
+    testBufferComposerGrowthPolicyAllocatedSizes<fixed_reserve_growth>(1000, 100, { 1000 });
+
+    // linear buffer remapped in place once allocations reach 4kb
+    testBufferComposerGrowthPolicyAllocatedSizes<geometric_growth<2>, remap_allocator<unsigned char, 4096>>(
+        64 * 1024, 1000, { 2000, 7000, 22000, 64 * 1024 });
+
+    // a copying reallocation moves the live range to the same offsets
+    {
+        remap_allocator<unsigned char, 1024 * 1024> allocator;
+        unsigned char* data = allocator.allocate(64);
+        for (size_t i = 0; i < 64; ++i) {
+            data[i] = static_cast<unsigned char>(i);
+        }
+        data = allocator.reallocate(data, 64, 10, 40, 128);
+        for (size_t i = 10; i < 40; ++i) {
+            assert(data[i] == i);
+        }
+        allocator.deallocate(data, 128);
+    }
+
+    // regrowth keeps data consumed from the front consistent
+    {
+        std::vector<unsigned char> generatedData(3000);
+        for (size_t i = 0; i < generatedData.size(); ++i) {
+            generatedData[i] = static_cast<unsigned char>(i % 251);
+        }
+
+        buffer_composer<16, 2, 256, remap_allocator<unsigned char, 1024>, buffer_composer_no_statistics,
+            additive_growth<512>> composer(4096, 4096);
+        size_t consumedTotal = 0;
+        for (size_t savedTotal = 0; savedTotal < generatedData.size(); savedTotal += 100) {
+            assert(composer.save(generatedData.data() + savedTotal, 100) == BufferComposerSaveStatus::Success);
+            assert(composer.consume(30) == BufferComposerConsumeStatus::Success);
+            consumedTotal += 30;
+        }
+
+        unsigned char* composedBuffer = nullptr;
+        size_t composedBufferSize = 0;
+        assert(composer.compose(composedBuffer, composedBufferSize) == BufferComposerComposeStatus::Success);
+        assert(composedBufferSize == generatedData.size() - consumedTotal);
+        assert(memcmp(composedBuffer, generatedData.data() + consumedTotal, composedBufferSize) == 0);
+    }
+}
+
+void testBufferComposerChecksum()
+{
+    using namespace restools;
+    using Composer = buffer_composer<16, 2, 256, std::allocator<unsigned char>, buffer_composer_no_statistics,
+        geometric_growth<2>, crc32c_checksum>;
+
+    std::vector<unsigned char> generatedData(5000);
+    for (size_t i = 0; i < generatedData.size(); ++i) {
+        generatedData[i] = static_cast<unsigned char>(i * 13 + (i >> 8));
+    }
+
+    // stack, linear buffer and chunks, with saves and reserve/commit
+    for (size_t dataSize : { 10, 100, 5000 }) {
+        Composer composer(512, generatedData.size() + 64);
+        for (size_t savedTotal = 0; savedTotal < dataSize;) {
+            const size_t toSaveSize = std::min<size_t>(37, dataSize - savedTotal);
+            if (savedTotal % 2 == 0) {
+                assert(composer.save(generatedData.data() + savedTotal, toSaveSize) == BufferComposerSaveStatus::Success);
+            }
+            else {
+                unsigned char* reservedBuffer = nullptr;
+                assert(composer.reserve(toSaveSize + 5, reservedBuffer) == BufferComposerSaveStatus::Success);
+                std::memcpy(reservedBuffer, generatedData.data() + savedTotal, toSaveSize);
+                assert(composer.commit(toSaveSize) == BufferComposerSaveStatus::Success);
+            }
+            savedTotal += toSaveSize;
+        }
+
+        unsigned char* composedBuffer = nullptr;
+        size_t composedBufferSize = 0;
+        uint32_t checksum = 0;
+        assert(composer.compose(composedBuffer, composedBufferSize, checksum) == BufferComposerComposeStatus::Success);
+        assert(composedBufferSize == dataSize && checksum == crc32c(generatedData.data(), dataSize));
+        assert(composer.checksum() == checksum);
+
+        composer.clear();
+        assert(composer.checksum() == 0);
+        assert(composer.save(generatedData.data(), 3) == BufferComposerSaveStatus::Success);
+        assert(composer.checksum() == crc32c(generatedData.data(), 3));
+    }
+
+#if defined(RESTOOLS_HAS_MAPPED_BUFFER)
+    {
+        Composer composer(64, generatedData.size());
+        assert(composer.enableSpill(1000));
+        saveGeneratedData(composer, generatedData, 300);
+        assert(composer.isSpilled() && composer.checksum() == crc32c(generatedData.data(), generatedData.size()));
+    }
+#endif
+
+    static_assert(std::is_empty_v<buffer_composer_no_checksum>);
+}
+
+void testBufferComposerParallelCompose()
+{
+    using namespace restools;
+
+    // non-periodic, a part copied to a wrong offset does not match
+    std::vector<unsigned char> generatedData(3 * 1024 * 1024 + 77);
+    for (size_t i = 0; i < generatedData.size(); ++i) {
+        generatedData[i] = static_cast<unsigned char>(i * 131 + i / 251);
+    }
+
+    copy_workers workers(3);
+    copy_workers callerOnly(0);
+
+    for (copy_workers* composeWorkers : { &workers, &callerOnly }) {
+        buffer_composer<64, 2, 4096> composer(1000, generatedData.size());
+        composer.enableParallelCompose(composeWorkers, 100000);
+
+        // stack and linear prefix, chunks filled by saves of odd sizes and reserve/commit
+        size_t savedSize = 0;
+        for (size_t i = 0; savedSize < generatedData.size(); ++i) {
+            const size_t size = std::min<size_t>(1 + (i * 7919) % 9000, generatedData.size() - savedSize);
+            if (i % 5 == 4) {
+                unsigned char* reservedBuffer = nullptr;
+                assert(composer.reserve(size, reservedBuffer) == BufferComposerSaveStatus::Success);
+                std::memcpy(reservedBuffer, generatedData.data() + savedSize, size);
+                assert(composer.commit(size) == BufferComposerSaveStatus::Success);
+            }
+            else {
+                assert(composer.save(generatedData.data() + savedSize, size) == BufferComposerSaveStatus::Success);
+            }
+            savedSize += size;
+        }
+
+        assert(composer.consume(12345) == BufferComposerConsumeStatus::Success);
+
+        unsigned char* composedData = nullptr;
+        size_t composedDataSize = 0;
+        assert(composer.compose(composedData, composedDataSize) == BufferComposerComposeStatus::Success);
+        assert(composedDataSize == generatedData.size() - 12345);
+        assert(std::memcmp(composedData, generatedData.data() + 12345, composedDataSize) == 0);
+
+        // appended after the rest of the data composed before
+        const size_t restSize = generatedData.size() - 312345;
+        assert(composer.consume(300000) == BufferComposerConsumeStatus::Success);
+        assert(composer.save(generatedData.data(), 200000) == BufferComposerSaveStatus::Success);
+        assert(composer.compose(composedData, composedDataSize) == BufferComposerComposeStatus::Success);
+        assert(composedDataSize == restSize + 200000);
+        assert(std::memcmp(composedData, generatedData.data() + 312345, restSize) == 0);
+        assert(std::memcmp(composedData + restSize, generatedData.data(), 200000) == 0);
+
+        // below the threshold it is composed on the calling thread
+        composer.clear();
+        assert(composer.save(generatedData.data(), 50000) == BufferComposerSaveStatus::Success);
+        assert(composer.compose(composedData, composedDataSize) == BufferComposerComposeStatus::Success);
+        assert(composedDataSize == 50000 && std::memcmp(composedData, generatedData.data(), composedDataSize) == 0);
+    }
+
+    // composers of several threads share the workers
+    std::vector<std::thread> threads;
+    for (size_t threadIndex = 0; threadIndex < 4; ++threadIndex) {
+        threads.emplace_back([&workers, &generatedData, threadIndex]()
+        {
+            buffer_composer<64, 2, 4096> composer(1000, generatedData.size());
+            composer.enableParallelCompose(&workers, 0);
+
+            for (size_t round = 0; round < 20; ++round) {
+                const size_t dataSize = 100000 + threadIndex * 1000 + round * 313;
+                composer.clear();
+                for (size_t savedSize = 0; savedSize < dataSize; savedSize += 3000) {
+                    assert(composer.save(generatedData.data() + savedSize, std::min<size_t>(3000, dataSize - savedSize)) ==
+                        BufferComposerSaveStatus::Success);
+                }
+
+                unsigned char* composedData = nullptr;
+                size_t composedDataSize = 0;
+                assert(composer.compose(composedData, composedDataSize) == BufferComposerComposeStatus::Success);
+                assert(composedDataSize == dataSize && std::memcmp(composedData, generatedData.data(), dataSize) == 0);
+            }
+        });
+    }
+
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+
+void testBufferComposerIncrementalCompose()
+{
+    using namespace restools;
+    using Composer = buffer_composer<16, 2, 256, std::allocator<unsigned char>, buffer_composer_statistics>;
+
+    std::vector<unsigned char> generatedData(20000);
+    for (size_t i = 0; i < generatedData.size(); ++i) {
+        generatedData[i] = static_cast<unsigned char>(i * 131 + i / 251);
+    }
+
+    unsigned char* composedData = nullptr;
+    size_t composedDataSize = 0;
+
+    // every compose copies the chunks saved since the previous one (the first one also the 16 byte stack buffer),
+    // moves of the growing buffer stay amortized
+    {
+        Composer composer(64, generatedData.size());
+        const buffer_composer_statistics& statistics = composer.statistics();
+        size_t savedSize = 0;
+
+        for (const size_t saveSize : { 10, 100, 300, 1000, 50, 3000, 1, 5000, 7, 2000, 8000 }) {
+            const size_t composedBytes = statistics.copiedBytesTo(BufferComposerTier::Composed);
+            assert(composer.save(generatedData.data() + savedSize, saveSize) == BufferComposerSaveStatus::Success);
+            savedSize += saveSize;
+
+            assert(composer.compose(composedData, composedDataSize) == BufferComposerComposeStatus::Success);
+            assert(composedDataSize == savedSize && std::memcmp(composedData, generatedData.data(), savedSize) == 0);
+            assert(statistics.copiedBytesTo(BufferComposerTier::Composed) - composedBytes <= saveSize + 16);
+        }
+
+        assert(statistics.copiedBytesTo(BufferComposerTier::Composed) <= savedSize);
+        assert(statistics.copiedBytesTo(BufferComposerTier::Linear) < 2 * savedSize);
+        assert(composer.segmentsCount() == 1);
+
+        // a save which fits the free tail of the composed buffer is not copied again
+        const size_t composedBytes = statistics.copiedBytesTo(BufferComposerTier::Composed);
+        assert(composer.save(generatedData.data(), 5) == BufferComposerSaveStatus::Success);
+        assert(composer.segmentsCount() == 1);
+        assert(composer.compose(composedData, composedDataSize) == BufferComposerComposeStatus::Success);
+        assert(composedDataSize == savedSize + 5 && std::memcmp(composedData + savedSize, generatedData.data(), 5) == 0);
+        assert(statistics.copiedBytesTo(BufferComposerTier::Composed) == composedBytes);
+
+        // the composed buffer is over linearBufferMaxSize, clear() frees it
+        composer.clear();
+        assert(statistics.footprint == 0);
+    }
+
+    // consume, reserve and saveRef between composes
+    {
+        Composer composer(64, generatedData.size());
+        assert(composer.save(generatedData.data(), 1000) == BufferComposerSaveStatus::Success);
+        assert(composer.compose(composedData, composedDataSize) == BufferComposerComposeStatus::Success);
+
+        assert(composer.consume(400) == BufferComposerConsumeStatus::Success);
+        unsigned char* reservedBuffer = nullptr;
+        assert(composer.reserve(3000, reservedBuffer) == BufferComposerSaveStatus::Success);
+        std::memcpy(reservedBuffer, generatedData.data() + 1000, 3000);
+        assert(composer.commit(3000) == BufferComposerSaveStatus::Success);
+        assert(composer.saveRef(generatedData.data() + 4000, 6000) == BufferComposerSaveStatus::Success);
+
+        assert(composer.compose(composedData, composedDataSize) == BufferComposerComposeStatus::Success);
+        assert(composedDataSize == 9600 && std::memcmp(composedData, generatedData.data() + 400, 9600) == 0);
+
+        // fully consumed composed data, the rest is composed into the same buffer
+        assert(composer.consume(9600) == BufferComposerConsumeStatus::Success);
+        assert(composer.save(generatedData.data(), 500) == BufferComposerSaveStatus::Success);
+        assert(composer.saveRef(generatedData.data() + 500, 500) == BufferComposerSaveStatus::Success);
+        assert(composer.compose(composedData, composedDataSize) == BufferComposerComposeStatus::Success);
+        assert(composedDataSize == 1000 && std::memcmp(composedData, generatedData.data(), 1000) == 0);
+
+        // released from its start after a consume
+        assert(composer.consume(100) == BufferComposerConsumeStatus::Success);
+        assert(composer.save(generatedData.data() + 1000, 2000) == BufferComposerSaveStatus::Success);
+        Composer::buffer_type releasedBuffer;
+        assert(composer.release(releasedBuffer) == BufferComposerComposeStatus::Success);
+        assert(releasedBuffer.size() == 2900 && std::memcmp(releasedBuffer.data(), generatedData.data() + 100, 2900) == 0);
+        assert(composer.savedCount() == 0);
+    }
+
+    // the composed buffer grows by GROWTH_POLICY up to linearBufferMaxSize
+    {
+        buffer_composer<16, 2, 256, std::allocator<unsigned char>, buffer_composer_statistics, additive_growth<4096>>
+            composer(10000, generatedData.size());
+        assert(composer.save(generatedData.data(), 1000) == BufferComposerSaveStatus::Success);
+        assert(composer.saveRef(generatedData.data() + 1000, 3500) == BufferComposerSaveStatus::Success);
+        assert(composer.compose(composedData, composedDataSize) == BufferComposerComposeStatus::Success);
+        assert(composedDataSize == 4500 && std::memcmp(composedData, generatedData.data(), 4500) == 0);
+        assert(composer.statistics().footprint == 8192);
+
+        assert(composer.save(generatedData.data() + 4500, 3000) == BufferComposerSaveStatus::Success);
+        assert(composer.segmentsCount() == 1);
+    }
+
+    // a policy allocating its maximum at once does not allocate saveBufferMaxCount for a composition
+    {
+        buffer_composer<16, 2, 256, std::allocator<unsigned char>, buffer_composer_statistics, fixed_reserve_growth>
+            composer(64, size_t(1) << 30);
+        size_t savedSize = 0;
+        for (const size_t saveSize : { 50, 150, 200 }) {
+            assert(composer.save(generatedData.data() + savedSize, saveSize) == BufferComposerSaveStatus::Success);
+            savedSize += saveSize;
+            assert(composer.compose(composedData, composedDataSize) == BufferComposerComposeStatus::Success);
+            assert(composedDataSize == savedSize && std::memcmp(composedData, generatedData.data(), savedSize) == 0);
+        }
+        assert(composer.statistics().footprint <= 4 * savedSize);
+        assert(composer.statistics().peakFootprint <= 4 * savedSize);
+    }
+
+    // a spilled composition is extended in the mapping
+    {
+        Composer composer(64, generatedData.size());
+        assert(composer.enableSpill(4000));
+        assert(composer.save(generatedData.data(), 5000) == BufferComposerSaveStatus::Success);
+        assert(composer.compose(composedData, composedDataSize) == BufferComposerComposeStatus::Success);
+        assert(composer.save(generatedData.data() + 5000, 5000) == BufferComposerSaveStatus::Success);
+        assert(composer.compose(composedData, composedDataSize) == BufferComposerComposeStatus::Success);
+        assert(composer.isSpilled() && composedDataSize == 10000);
+        assert(std::memcmp(composedData, generatedData.data(), 10000) == 0);
+    }
+}
+
+void testBufferComposerSaveRef()
+{
+    using namespace restools;
+
+    std::vector<unsigned char> generatedData(20000);
+    for (size_t i = 0; i < generatedData.size(); ++i) {
+        generatedData[i] = static_cast<unsigned char>(i * 131 + i / 251);
+    }
+
+    // copies and references mixed in every tier: stack, linear, after chunks and between references
+    {
+        buffer_composer<64, 2, 256, std::allocator<unsigned char>, buffer_composer_statistics, geometric_growth<2>, crc32c_checksum>
+            composer(512, generatedData.size());
+
+        const unsigned char* data = generatedData.data();
+        assert(composer.save(data, 10) == BufferComposerSaveStatus::Success);
+        assert(composer.saveRef(data + 10, 3000) == BufferComposerSaveStatus::Success);
+        assert(composer.save(data + 3010, 700) == BufferComposerSaveStatus::Success);
+        assert(composer.saveRef(data + 3710, 5) == BufferComposerSaveStatus::Success);
+        assert(composer.saveRef(data + 3715, 4000) == BufferComposerSaveStatus::Success);
+        unsigned char* reservedBuffer = nullptr;
+        assert(composer.reserve(100, reservedBuffer) == BufferComposerSaveStatus::Success);
+        std::memcpy(reservedBuffer, data + 7715, 100);
+        assert(composer.commit(100) == BufferComposerSaveStatus::Success);
+        assert(composer.saveRef(data + 7815, 2185) == BufferComposerSaveStatus::Success);
+        assert(composer.savedCount() == 10000);
+
+        // references are only copied by compose()
+        assert(composer.statistics().savedBytes == 10000);
+        assert(composer.statistics().copiedBytesTo(BufferComposerTier::Stack) == 10);
+        assert(composer.statistics().copiedBytesTo(BufferComposerTier::Chunks) == 700);
+
+        std::vector<BufferComposerSegment> segments(composer.segmentsCount());
+        size_t segmentsCount = 0;
+        size_t composedDataSize = 0;
+        assert(composer.composeSegments(segments.data(), segments.size(), segmentsCount, composedDataSize) ==
+            BufferComposerComposeStatus::Success);
+        assert(segmentsCount == 7 && composedDataSize == 10000);
+        assert(segments[1].data == data + 10 && segments[1].size == 3000);
+        assert(segments[4].data == data + 3715 && segments[6].data == data + 7815);
+        composer.clear();
+
+        // the same sequence composed contiguously, then consumed across references
+        assert(composer.save(data, 10) == BufferComposerSaveStatus::Success);
+        assert(composer.saveRef(data + 10, 3000) == BufferComposerSaveStatus::Success);
+        assert(composer.save(data + 3010, 700) == BufferComposerSaveStatus::Success);
+        assert(composer.saveRef(data + 3710, 6290) == BufferComposerSaveStatus::Success);
+
+        assert(composer.consume(1000) == BufferComposerConsumeStatus::Success);
+        assert(composer.frontSegment().data == data + 1000);
+        assert(composer.consume(3000) == BufferComposerConsumeStatus::Success);
+        assert(composer.frontSegment().data == data + 4000 && composer.frontSegment().size == 6000);
+
+        unsigned char* composedData = nullptr;
+        uint32_t checksum = 0;
+        assert(composer.compose(composedData, composedDataSize, checksum) == BufferComposerComposeStatus::Success);
+        assert(composedDataSize == 6000 && std::memcmp(composedData, data + 4000, 6000) == 0);
+        assert(checksum == crc32c(data, 10000));
+        assert(composer.saveRef(data, 1) == BufferComposerSaveStatus::Success);
+        assert(composer.compose(composedData, composedDataSize) == BufferComposerComposeStatus::Success);
+        assert(composedDataSize == 6001 && std::memcmp(composedData + 6000, data, 1) == 0);
+        composer.clear();
+
+        assert(composer.saveRef(nullptr, 1) == BufferComposerSaveStatus::NullBuffer);
+        assert(composer.saveRef(data, 0) == BufferComposerSaveStatus::ZeroBufferSize);
+        assert(composer.saveRef(data, generatedData.size() + 1) == BufferComposerSaveStatus::MaxSavedBufferCountLimited);
+    }
+
+    // release copies references into the released buffer
+    {
+        buffer_composer<64, 2, 256> composer(512, generatedData.size());
+        assert(composer.saveRef(generatedData.data(), 5000) == BufferComposerSaveStatus::Success);
+        assert(composer.save(generatedData.data() + 5000, 5000) == BufferComposerSaveStatus::Success);
+
+        buffer_composer<64, 2, 256>::buffer_type releasedBuffer;
+        assert(composer.release(releasedBuffer) == BufferComposerComposeStatus::Success);
+        assert(releasedBuffer.size() == 10000 && std::memcmp(releasedBuffer.data(), generatedData.data(), 10000) == 0);
+        assert(composer.savedCount() == 0);
+    }
+
+#if defined(RESTOOLS_HAS_MAPPED_BUFFER)
+    // over the spill threshold references are copied into the spill
+    {
+        buffer_composer<64, 2, 256> composer(512, generatedData.size());
+        assert(composer.enableSpill(8000));
+        assert(composer.saveRef(generatedData.data(), 6000) == BufferComposerSaveStatus::Success);
+        assert(!composer.isSpilled());
+        assert(composer.saveRef(generatedData.data() + 6000, 6000) == BufferComposerSaveStatus::Success);
+        assert(composer.isSpilled());
+
+        unsigned char* composedData = nullptr;
+        size_t composedDataSize = 0;
+        assert(composer.compose(composedData, composedDataSize) == BufferComposerComposeStatus::Success);
+        assert(composedDataSize == 12000 && std::memcmp(composedData, generatedData.data(), 12000) == 0);
+    }
+#endif
+}
+
 template <size_t STACK_BUFFER_MAX>
 void testBufferComposerWithDataSizeInterval(
     size_t linearBufferMax, 
@@ -170,5 +1217,19 @@ void testBufferComposer()
 {
     testBufferComposerNegative();
     testBufferComposerBufferIsOverlapping();
+    testBufferComposerSegments();
+    testBufferComposerMemoryResource();
+    testBufferComposerChunkPacking();
+    testBufferComposerReserveCommit();
+    testBufferComposerMove();
+    testBufferComposerReleaseAdopt();
+    testBufferComposerConsume();
+    testBufferComposerSpill();
+    testBufferComposerStatistics();
+    testBufferComposerGrowthPolicy();
+    testBufferComposerChecksum();
+    testBufferComposerParallelCompose();
+    testBufferComposerSaveRef();
+    testBufferComposerIncrementalCompose();
     testBufferComposerWithDataSizeInterval();
 }
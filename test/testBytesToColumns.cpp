@@ -0,0 +1,93 @@
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+#include "restools/bytes_to_columns.hpp"
+
+namespace
+{
+    enum class RecordKind : uint8_t
+    {
+        First = 1,
+        Second = 2,
+    };
+
+    // Packed wire record of 23 bytes: id u64 big, price double little, quantity i32 big, flags u16 little, kind u8
+    constexpr size_t RECORD_SIZE = 23;
+
+    std::vector<unsigned char> makeRecords(size_t count)
+    {
+        std::vector<unsigned char> records(count * RECORD_SIZE);
+        for (size_t i = 0; i < count; ++i) {
+            unsigned char* record = records.data() + i * RECORD_SIZE;
+            restools::typeToBytesFast<std::endian::big>(static_cast<uint64_t>(0x0102030405060708ull * (i + 1)), record);
+            restools::typeToBytesFast<std::endian::little>(static_cast<double>(i) * 0.5, record + 8);
+            restools::typeToBytesFast<std::endian::big>(static_cast<int32_t>(i * 7) - 1000, record + 16);
+            restools::typeToBytesFast<std::endian::little>(static_cast<uint16_t>(i * 3), record + 20);
+            record[22] = static_cast<unsigned char>(i % 2 == 0 ? RecordKind::First : RecordKind::Second);
+        }
+        return records;
+    }
+}
+
+void testBytesToColumns()
+{
+    using namespace restools;
+
+    // counts around the gather width and the tile size, the last record is at the end of the buffer
+    for (size_t count : { size_t(0), size_t(1), size_t(7), size_t(8), size_t(9), size_t(713), size_t(1500) }) {
+        const std::vector<unsigned char> records = makeRecords(count);
+
+        std::vector<uint64_t> ids(count);
+        std::vector<double> prices(count);
+        std::vector<int32_t> quantities(count);
+        std::vector<uint16_t> flags(count);
+        std::vector<RecordKind> kinds(count);
+        // the same field read in the other endianness and as a narrower type
+        std::vector<uint16_t> flagsSwapped(count);
+        std::vector<uint8_t> quantitiesLowBytes(count);
+
+        const record_column columns[] = {
+            record_column(0, ids.data(), true),
+            record_column(8, prices.data(), false),
+            record_column(16, quantities.data(), true),
+            record_column(20, flags.data(), false),
+            record_column(22, kinds.data(), false),
+            record_column(20, flagsSwapped.data(), true),
+            record_column(19, quantitiesLowBytes.data(), false),
+        };
+
+        assert(bytesToColumnsSafe(records.data(), records.size(), RECORD_SIZE, count, columns, std::size(columns)) ==
+            BytesToTypeStatus::Success);
+
+        for (size_t i = 0; i < count; ++i) {
+            assert(ids[i] == 0x0102030405060708ull * (i + 1));
+            assert(prices[i] == static_cast<double>(i) * 0.5);
+            assert(quantities[i] == static_cast<int32_t>(i * 7) - 1000);
+            assert(flags[i] == static_cast<uint16_t>(i * 3));
+            assert(kinds[i] == (i % 2 == 0 ? RecordKind::First : RecordKind::Second));
+            assert(flagsSwapped[i] == detail::byteSwap(static_cast<uint16_t>(i * 3)));
+            assert(quantitiesLowBytes[i] == static_cast<uint8_t>(static_cast<int32_t>(i * 7) - 1000));
+        }
+    }
+
+    // failures
+    {
+        const std::vector<unsigned char> records = makeRecords(4);
+        std::vector<uint32_t> values(8);
+
+        const record_column fitting[] = { record_column(16, values.data(), true) };
+        assert(bytesToColumnsSafe(records.data(), records.size() - 1, RECORD_SIZE, 4, fitting, 1) == BytesToTypeStatus::BufferIsOverflow);
+        assert(bytesToColumnsSafe(records.data(), records.size(), 0, 4, fitting, 1) == BytesToTypeStatus::BufferIsOverflow);
+
+        const record_column outside[] = { record_column(20, values.data(), true) };
+        assert(bytesToColumnsSafe(records.data(), records.size(), RECORD_SIZE, 4, outside, 1) == BytesToTypeStatus::BufferIsOverflow);
+
+        const record_column overlapping[] = { record_column(0, values.data(), true), record_column(4, values.data() + 3, true) };
+        assert(bytesToColumnsSafe(records.data(), records.size(), RECORD_SIZE, 4, overlapping, 2) == BytesToTypeStatus::BufferIsOverlapping);
+
+        std::vector<unsigned char> inPlace = records;
+        const record_column overSource[] = { record_column(0, reinterpret_cast<uint32_t*>(inPlace.data() + 4), true) };
+        assert(bytesToColumnsSafe(inPlace.data(), inPlace.size(), RECORD_SIZE, 4, overSource, 1) == BytesToTypeStatus::BufferIsOverlapping);
+    }
+}
@@ -1,5 +1,6 @@
 #include <limits>
 #include <cassert>
+#include <cstdint>
 
 #include "restools/bytes_to_type.hpp"
 
@@ -59,6 +60,57 @@ void testBytesToIntegerForType()
     testBytesToIntegerCheckValue(std::numeric_limits<T>::max());
 }
 
+template <std::endian ENDIAN, typename T>
+constexpr T testBytesToTypeConstexpr(const unsigned char* srcBytes)
+{
+    T value = 0;
+    restools::bytesToTypeFast<ENDIAN>(srcBytes, value);
+    return value;
+}
+
+template <std::endian ENDIAN, typename T, size_t SIZE = sizeof(T)>
+constexpr unsigned char testTypeToBytesConstexpr(T value, size_t byteIndex)
+{
+    unsigned char dstBytes[SIZE] = { 0 };
+    restools::typeToBytesFast<ENDIAN>(value, dstBytes);
+    return dstBytes[byteIndex];
+}
+
+void testBytesToTypeCompileTimeEndian()
+{
+    using namespace restools;
+
+    static constexpr unsigned char testBytes[] = { 0x01, 0x23, 0x45, 0x67, 0x89, 0xAB, 0xCD, 0xEF };
+
+    static_assert(testBytesToTypeConstexpr<std::endian::big, uint16_t>(testBytes) == 0x0123);
+    static_assert(testBytesToTypeConstexpr<std::endian::little, uint16_t>(testBytes) == 0x2301);
+    static_assert(testBytesToTypeConstexpr<std::endian::big, uint32_t>(testBytes) == 0x01234567);
+    static_assert(testBytesToTypeConstexpr<std::endian::little, int32_t>(testBytes) == 0x67452301);
+    static_assert(testBytesToTypeConstexpr<std::endian::big, uint64_t>(testBytes) == 0x0123456789ABCDEFull);
+    static_assert(testBytesToTypeConstexpr<std::endian::little, uint64_t>(testBytes) == 0xEFCDAB8967452301ull);
+    static_assert(testTypeToBytesConstexpr<std::endian::big>(uint32_t(0x01234567), 0) == 0x01);
+    static_assert(testTypeToBytesConstexpr<std::endian::little>(uint32_t(0x01234567), 0) == 0x67);
+    static_assert(detail::byteSwap<int16_t>(0x0123) == 0x2301);
+
+    uint64_t bigValue = 0;
+    bytesToTypeFast<std::endian::big>(testBytes, bigValue);
+    assert(bigValue == 0x0123456789ABCDEFull);
+
+    uint64_t littleValue = 0;
+    bytesToTypeFast<std::endian::little>(testBytes, littleValue);
+    assert(littleValue == 0xEFCDAB8967452301ull);
+
+    double doubleValue = 0;
+    bytesToTypeFast<std::endian::big>(testBytes, doubleValue);
+    unsigned char doubleBytes[sizeof(double)] = { 0 };
+    typeToBytesFast<std::endian::big>(doubleValue, doubleBytes);
+    assert(memcmp(doubleBytes, testBytes, sizeof(double)) == 0);
+
+    unsigned char runtimeBytes[sizeof(uint32_t)] = { 0 };
+    typeToBytesFast(uint32_t(0x01234567), runtimeBytes, true);
+    assert(memcmp(runtimeBytes, testBytes, sizeof(runtimeBytes)) == 0);
+}
+
 void testBytesToTypeIsOverlapping()
 {
     static constexpr size_t typeSizeOf = sizeof(unsigned long long);
@@ -99,4 +151,5 @@ void testBytesToType()
     testBytesToTypeCheckValueForEndian<TestStruct>(testStruct, true);
 
     testBytesToTypeIsOverlapping();
+    testBytesToTypeCompileTimeEndian();
 }
\ No newline at end of file
@@ -0,0 +1,108 @@
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "restools/bytes_to_type_array.hpp"
+
+template <size_t VALUE_SIZE>
+void testByteSwapArrayKernel(restools::detail::ByteSwapArrayKernel<VALUE_SIZE> kernel)
+{
+    std::vector<unsigned char> srcBytes(VALUE_SIZE * 130 + 3);
+    for (size_t i = 0; i < srcBytes.size(); ++i) {
+        srcBytes[i] = static_cast<unsigned char>(i * 7 + 1);
+    }
+
+    for (size_t offset = 0; offset < 3; ++offset) {
+        for (size_t count = 0; count < 130; ++count) {
+            std::vector<unsigned char> dstBytes(count * VALUE_SIZE + 1, 0xEE);
+            kernel(srcBytes.data() + offset, dstBytes.data(), count);
+
+            for (size_t i = 0; i < count; ++i) {
+                for (size_t j = 0; j < VALUE_SIZE; ++j) {
+                    assert(dstBytes[i * VALUE_SIZE + j] == srcBytes[offset + i * VALUE_SIZE + VALUE_SIZE - 1 - j]);
+                }
+            }
+            assert(dstBytes[count * VALUE_SIZE] == 0xEE);
+
+            std::vector<unsigned char> inPlaceBytes(srcBytes.begin() + offset, srcBytes.begin() + offset + count * VALUE_SIZE);
+            kernel(inPlaceBytes.data(), inPlaceBytes.data(), count);
+            assert(std::equal(inPlaceBytes.begin(), inPlaceBytes.end(), dstBytes.begin()));
+        }
+    }
+}
+
+template <size_t VALUE_SIZE>
+void testByteSwapArrayKernels()
+{
+    using namespace restools;
+
+    testByteSwapArrayKernel<VALUE_SIZE>(&detail::byteSwapArrayScalar<VALUE_SIZE>);
+
+#if defined(RESTOOLS_X86)
+    if (cpuSupportsSsse3()) {
+        testByteSwapArrayKernel<VALUE_SIZE>(&detail::byteSwapArraySsse3<VALUE_SIZE>);
+    }
+
+    if (cpuSupportsAvx2()) {
+        testByteSwapArrayKernel<VALUE_SIZE>(&detail::byteSwapArrayAvx2<VALUE_SIZE>);
+    }
+#endif
+}
+
+template <typename T>
+void testBytesToTypeArrayForType(bool isBigEndian)
+{
+    using namespace restools;
+
+    static constexpr size_t count = 77;
+    std::vector<T> srcValues(count);
+    for (size_t i = 0; i < count; ++i) {
+        srcValues[i] = static_cast<T>(i * 0x0123456789ABCDEFull);
+    }
+
+    std::vector<unsigned char> bytes(count * sizeof(T));
+    assert(typeToBytesArraySafe(srcValues.data(), count, bytes.data(), bytes.size(), isBigEndian) == TypeToByteStatus::Success);
+
+    for (size_t i = 0; i < count; ++i) {
+        T expectedValue;
+        bytesToTypeFast(bytes.data() + i * sizeof(T), expectedValue, isBigEndian);
+        assert(memcmp(&expectedValue, &srcValues[i], sizeof(T)) == 0);
+    }
+
+    std::vector<T> dstValues(count);
+    assert(bytesToTypeArraySafe(bytes.data(), bytes.size(), dstValues.data(), count, isBigEndian) == BytesToTypeStatus::Success);
+    assert(memcmp(dstValues.data(), srcValues.data(), bytes.size()) == 0);
+
+    assert(bytesToTypeArraySafe(bytes.data(), bytes.size() - 1, dstValues.data(), count, isBigEndian) == BytesToTypeStatus::BufferIsOverflow);
+    assert(typeToBytesArraySafe(srcValues.data(), count, bytes.data(), bytes.size() - 1, isBigEndian) == TypeToByteStatus::BufferIsOverflow);
+
+    // count * sizeof(T) wraps around to a size which fits
+    if constexpr (sizeof(T) > 1) {
+        const size_t wrappingCount = std::numeric_limits<size_t>::max() / sizeof(T) + 2;
+        assert(bytesToTypeArraySafe(bytes.data(), bytes.size(), dstValues.data(), wrappingCount, isBigEndian) == BytesToTypeStatus::BufferIsOverflow);
+        assert(typeToBytesArraySafe(srcValues.data(), wrappingCount, bytes.data(), bytes.size(), isBigEndian) == TypeToByteStatus::BufferIsOverflow);
+    }
+
+    unsigned char* valuesAsBytes = reinterpret_cast<unsigned char*>(dstValues.data());
+    assert(bytesToTypeArraySafe(valuesAsBytes + 1, bytes.size(), dstValues.data(), count, isBigEndian) == BytesToTypeStatus::BufferIsOverlapping);
+    assert(typeToBytesArraySafe(dstValues.data(), count, valuesAsBytes + 1, bytes.size(), isBigEndian) == TypeToByteStatus::BufferIsOverlapping);
+
+    bytesToTypeArrayFast(bytes.data(), count, reinterpret_cast<T*>(bytes.data()), isBigEndian);
+    assert(memcmp(bytes.data(), srcValues.data(), bytes.size()) == 0);
+}
+
+void testBytesToTypeArray()
+{
+    testByteSwapArrayKernels<2>();
+    testByteSwapArrayKernels<4>();
+    testByteSwapArrayKernels<8>();
+
+    for (bool isBigEndian : { false, true }) {
+        testBytesToTypeArrayForType<uint8_t>(isBigEndian);
+        testBytesToTypeArrayForType<uint16_t>(isBigEndian);
+        testBytesToTypeArrayForType<int32_t>(isBigEndian);
+        testBytesToTypeArrayForType<uint64_t>(isBigEndian);
+        testBytesToTypeArrayForType<double>(isBigEndian);
+    }
+}
@@ -0,0 +1,107 @@
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+
+#include "restools/bytes_writer.hpp"
+#include "restools/bytes_reader.hpp"
+
+void testBytesWriterMixedEndian()
+{
+    using namespace restools;
+
+    unsigned char buffer[32] = { 0 };
+    bytes_writer writer(buffer, sizeof(buffer));
+
+    assert(writer.require(15) == TypeToByteStatus::Success);
+    writer.writeFast<std::endian::big>(uint32_t(0x01234567), uint16_t(0x89AB));
+    writer.writeFast<std::endian::little>(uint32_t(0x01234567));
+    writer.writeFast<std::endian::big>(uint8_t(0xCD));
+    writer.writeFast<std::endian::little>(uint32_t(0x89ABCDEF));
+    assert(writer.position() == 15 && writer.remaining() == 17);
+
+    static constexpr unsigned char expectedBytes[] = {
+        0x01, 0x23, 0x45, 0x67, 0x89, 0xAB,
+        0x67, 0x45, 0x23, 0x01,
+        0xCD,
+        0xEF, 0xCD, 0xAB, 0x89 };
+    assert(memcmp(buffer, expectedBytes, sizeof(expectedBytes)) == 0);
+
+    bytes_reader reader(buffer, writer.position());
+    uint32_t bigValue = 0;
+    uint16_t shortValue = 0;
+    uint32_t littleValue = 0;
+    uint8_t byteValue = 0;
+    uint32_t lastValue = 0;
+
+    assert(reader.read<std::endian::big>(bigValue, shortValue) == BytesToTypeStatus::Success);
+    assert(reader.require(9) == BytesToTypeStatus::Success);
+    reader.readFast<std::endian::little>(littleValue);
+    reader.readFast<std::endian::big>(byteValue);
+    reader.readFast<std::endian::little>(lastValue);
+
+    assert(bigValue == 0x01234567 && shortValue == 0x89AB && littleValue == 0x01234567);
+    assert(byteValue == 0xCD && lastValue == 0x89ABCDEF);
+    assert(reader.remaining() == 0);
+}
+
+void testBytesWriterOverflow()
+{
+    using namespace restools;
+
+    unsigned char buffer[10] = { 0 };
+    bytes_writer writer(buffer, sizeof(buffer));
+
+    assert(writer.write<std::endian::big>(uint64_t(1), uint32_t(2)) == TypeToByteStatus::BufferIsOverflow);
+    assert(writer.position() == 0);
+    assert(writer.write<std::endian::big>(uint64_t(1)) == TypeToByteStatus::Success);
+    assert(writer.write<std::endian::big>(uint32_t(2)) == TypeToByteStatus::BufferIsOverflow);
+    assert(writer.require(3) == TypeToByteStatus::BufferIsOverflow);
+
+    const unsigned char bytes[] = { 0xAA, 0xBB, 0xCC };
+    assert(writer.writeBytes(bytes, 3) == TypeToByteStatus::BufferIsOverflow);
+    assert(writer.writeBytes(bytes, 2) == TypeToByteStatus::Success);
+    assert(writer.remaining() == 0);
+
+    const uint16_t values[] = { 1, 2 };
+    assert(writer.writeArray<std::endian::little>(values, 1) == TypeToByteStatus::BufferIsOverflow);
+
+    bytes_reader reader(buffer, sizeof(buffer));
+    uint64_t value = 0;
+    uint32_t overflowValue = 0;
+    assert(reader.read<std::endian::big>(value) == BytesToTypeStatus::Success && value == 1);
+    assert(reader.read<std::endian::big>(overflowValue) == BytesToTypeStatus::BufferIsOverflow);
+    assert(reader.skip(3) == BytesToTypeStatus::BufferIsOverflow);
+
+    unsigned char readBytes[2] = { 0 };
+    assert(reader.readBytes(readBytes, 2) == BytesToTypeStatus::Success && memcmp(readBytes, bytes, 2) == 0);
+    assert(reader.skip(1) == BytesToTypeStatus::BufferIsOverflow);
+}
+
+void testBytesWriterArrays()
+{
+    using namespace restools;
+
+    const uint32_t values[] = { 0x01020304, 0x05060708, 0x090A0B0C, 0x0D0E0F10, 0x11121314 };
+    static constexpr size_t count = sizeof(values) / sizeof(values[0]);
+    unsigned char buffer[sizeof(values) + 2] = { 0 };
+
+    bytes_writer writer(buffer, sizeof(buffer));
+    assert(writer.write<std::endian::big>(uint16_t(count)) == TypeToByteStatus::Success);
+    assert(writer.writeArray<std::endian::big>(values, count) == TypeToByteStatus::Success);
+    assert(buffer[2] == 0x01 && buffer[5] == 0x04);
+
+    bytes_reader reader(buffer, sizeof(buffer));
+    uint16_t readCount = 0;
+    uint32_t readValues[count] = { 0 };
+    assert(reader.read<std::endian::big>(readCount) == BytesToTypeStatus::Success && readCount == count);
+    assert(reader.readArray<std::endian::big>(readValues, count + 1) == BytesToTypeStatus::BufferIsOverflow);
+    assert(reader.readArray<std::endian::big>(readValues, count) == BytesToTypeStatus::Success);
+    assert(memcmp(readValues, values, sizeof(values)) == 0);
+}
+
+void testBytesWriter()
+{
+    testBytesWriterMixedEndian();
+    testBytesWriterOverflow();
+    testBytesWriterArrays();
+}
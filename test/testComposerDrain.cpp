@@ -0,0 +1,197 @@
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "restools/composer_drain.hpp"
+#include "restools/composer_slab.hpp"
+
+#if defined(RESTOOLS_HAS_COMPOSER_DRAIN)
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace
+{
+    using DrainedComposer = restools::buffer_composer<16, 2, 256>;
+
+    // Composers in the stack, linear and chunk tiers, returns the bytes they hold one after another
+    std::vector<unsigned char> fillComposers(std::vector<DrainedComposer>& composers, size_t round)
+    {
+        std::vector<unsigned char> expected;
+
+        for (size_t i = 0; i < composers.size(); ++i) {
+            const size_t dataSize = (i % 3 == 0) ? 10 : (i % 3 == 1) ? 100 : 20000 + i;
+            for (size_t savedTotal = 0; savedTotal < dataSize;) {
+                unsigned char fragment[97];
+                const size_t fragmentSize = std::min(sizeof(fragment), dataSize - savedTotal);
+                for (size_t j = 0; j < fragmentSize; ++j) {
+                    fragment[j] = static_cast<unsigned char>(round * 7 + i * 3 + savedTotal + j);
+                }
+                assert(composers[i].save(fragment, fragmentSize) == restools::BufferComposerSaveStatus::Success);
+                expected.insert(expected.end(), fragment, fragment + fragmentSize);
+                savedTotal += fragmentSize;
+            }
+        }
+
+        return expected;
+    }
+
+    std::vector<unsigned char> readAvailable(int fd)
+    {
+        std::vector<unsigned char> result;
+        unsigned char buffer[4096];
+        for (;;) {
+            const ssize_t readSize = read(fd, buffer, sizeof(buffer));
+            if (readSize <= 0) {
+                break;
+            }
+            result.insert(result.end(), buffer, buffer + readSize);
+        }
+        return result;
+    }
+
+    // Drains through a non-blocking descriptor whose reading end is emptied whenever it is full
+    void testComposerDrainNonBlocking(int writeFd, int readFd)
+    {
+        using namespace restools;
+
+        assert(fcntl(writeFd, F_SETFL, fcntl(writeFd, F_GETFL) | O_NONBLOCK) == 0);
+        assert(fcntl(readFd, F_SETFL, fcntl(readFd, F_GETFL) | O_NONBLOCK) == 0);
+
+        std::vector<DrainedComposer> composers;
+        for (size_t i = 0; i < 30; ++i) {
+            composers.emplace_back(512, 1 << 20);
+        }
+
+        composer_drain<DrainedComposer> drain;
+
+        for (size_t round = 0; round < 2; ++round) {
+            const std::vector<unsigned char> expected = fillComposers(composers, round);
+            for (DrainedComposer& composer : composers) {
+                assert(drain.add(composer) == BufferComposerComposeStatus::Success);
+            }
+            assert(drain.pendingSize() == expected.size());
+
+            std::vector<unsigned char> received;
+            size_t wouldBlockCount = 0;
+            for (;;) {
+                size_t writtenSize = 0;
+                const ComposerDrainStatus status = drain.drain(writeFd, writtenSize);
+                const std::vector<unsigned char> available = readAvailable(readFd);
+                received.insert(received.end(), available.begin(), available.end());
+
+                if (status == ComposerDrainStatus::Success) {
+                    break;
+                }
+
+                assert(status == ComposerDrainStatus::WouldBlock);
+                ++wouldBlockCount;
+
+                // written composers are cleared and reusable, the rest wait for the descriptor
+                assert(composers.front().savedCount() == 0 && composers.back().savedCount() > 0);
+            }
+
+            assert(wouldBlockCount > 0 && drain.empty());
+            assert(received == expected);
+
+            for (const DrainedComposer& composer : composers) {
+                assert(composer.savedCount() == 0);
+            }
+        }
+    }
+}
+#endif
+
+void testComposerDrain()
+{
+#if defined(RESTOOLS_HAS_COMPOSER_DRAIN)
+    using namespace restools;
+
+    int pipeFds[2] = {};
+    assert(pipe(pipeFds) == 0);
+    testComposerDrainNonBlocking(pipeFds[1], pipeFds[0]);
+    close(pipeFds[0]);
+    close(pipeFds[1]);
+
+    int socketFds[2] = {};
+    assert(socketpair(AF_UNIX, SOCK_STREAM, 0, socketFds) == 0);
+    // socket buffers may take everything at once otherwise
+    const int sendBufferSize = 16384;
+    assert(setsockopt(socketFds[0], SOL_SOCKET, SO_SNDBUF, &sendBufferSize, sizeof(sendBufferSize)) == 0);
+    testComposerDrainNonBlocking(socketFds[0], socketFds[1]);
+    close(socketFds[0]);
+    close(socketFds[1]);
+
+    // a file takes everything in one drain
+    {
+        FILE* file = std::tmpfile();
+        assert(file);
+        const int fileFd = fileno(file);
+
+        std::vector<DrainedComposer> composers;
+        for (size_t i = 0; i < 7; ++i) {
+            composers.emplace_back(512, 1 << 20);
+        }
+        const std::vector<unsigned char> expected = fillComposers(composers, 5);
+
+        composer_drain<DrainedComposer> drain;
+        for (DrainedComposer& composer : composers) {
+            assert(drain.add(composer) == BufferComposerComposeStatus::Success);
+        }
+
+        DrainedComposer emptyComposer(512, 1024);
+        assert(drain.add(emptyComposer) == BufferComposerComposeStatus::NoDataSaved);
+
+        size_t writtenSize = 0;
+        assert(drain.drain(fileFd, writtenSize) == ComposerDrainStatus::Success && writtenSize == expected.size());
+
+        std::vector<unsigned char> written(expected.size());
+        assert(pread(fileFd, written.data(), written.size(), 0) == static_cast<ssize_t>(written.size()));
+        assert(written == expected);
+        std::fclose(file);
+
+        // a closed descriptor fails, composers stay composed
+        const std::vector<unsigned char> nextExpected = fillComposers(composers, 6);
+        assert(drain.add(composers[0]) == BufferComposerComposeStatus::Success);
+        assert(drain.drain(-1, writtenSize) == ComposerDrainStatus::WriteFailed && writtenSize == 0);
+        assert(composers[0].savedCount() > 0);
+    }
+
+    // slab composers drain the same way and go idle once written
+    {
+        FILE* file = std::tmpfile();
+        assert(file);
+        const int fileFd = fileno(file);
+
+        composer_slab slab(1024 * 1024);
+        std::vector<slab_composer<>> composers;
+        std::vector<unsigned char> expected;
+        for (size_t i = 0; i < 5; ++i) {
+            composers.emplace_back(1024, 65536, slab);
+            const std::vector<unsigned char> data(100 + i * 300, static_cast<unsigned char>(i + 1));
+            assert(composers[i].save(data.data(), data.size()) == BufferComposerSaveStatus::Success);
+            expected.insert(expected.end(), data.begin(), data.end());
+        }
+
+        composer_drain<slab_composer<>> drain;
+        for (slab_composer<>& composer : composers) {
+            assert(drain.add(composer) == BufferComposerComposeStatus::Success);
+        }
+        slab_composer<> idleComposer(1024, 65536, slab);
+        assert(drain.add(idleComposer) == BufferComposerComposeStatus::NoDataSaved);
+        assert(drain.pendingSize() == expected.size());
+
+        size_t writtenSize = 0;
+        assert(drain.drain(fileFd, writtenSize) == ComposerDrainStatus::Success && writtenSize == expected.size());
+
+        std::vector<unsigned char> written(expected.size());
+        assert(pread(fileFd, written.data(), written.size(), 0) == static_cast<ssize_t>(written.size()));
+        assert(written == expected);
+        for (const slab_composer<>& composer : composers) {
+            assert(composer.isIdle());
+        }
+        std::fclose(file);
+    }
+#endif
+}
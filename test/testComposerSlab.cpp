@@ -0,0 +1,257 @@
+#include <cassert>
+#include <cstring>
+#include <vector>
+
+#include "restools/composer_slab.hpp"
+
+namespace
+{
+    std::vector<unsigned char> generateSlabData(size_t size, size_t seed)
+    {
+        std::vector<unsigned char> data(size);
+        for (size_t i = 0; i < size; ++i) {
+            data[i] = static_cast<unsigned char>(seed * 13 + i);
+        }
+        return data;
+    }
+
+    template <typename COMPOSER>
+    void assertSlabComposerData(const COMPOSER& composer, const std::vector<unsigned char>& expected)
+    {
+        std::vector<unsigned char> data(composer.savedCount());
+        assert(data.size() == expected.size());
+        assert(composer.peek(0, data.data(), data.size()) == data.size());
+        assert(data == expected);
+    }
+}
+
+void testComposerSlabPooling()
+{
+    using namespace restools;
+
+    composer_slab slab(16 * 1024 * 1024);
+    std::vector<slab_buffer_composer<>> composers;
+    for (size_t i = 0; i < 1000; ++i) {
+        composers.emplace_back(1024, 65536, slab_allocator<unsigned char>(slab));
+    }
+
+    assert(slab.footprint() == 0 && slab.usedSize() == 0);
+
+    size_t roundFootprint = 0;
+    for (size_t round = 0; round < 3; ++round) {
+        std::vector<std::vector<unsigned char>> expected(composers.size());
+
+        // stack, linear and chunk tiers
+        for (size_t i = 0; i < composers.size(); ++i) {
+            expected[i] = generateSlabData((i % 3 == 0) ? 20 : (i % 3 == 1) ? 500 : 5000 + i, round + i);
+            for (size_t offset = 0; offset < expected[i].size(); offset += 100) {
+                const size_t size = std::min<size_t>(100, expected[i].size() - offset);
+                assert(composers[i].save(expected[i].data() + offset, size) == BufferComposerSaveStatus::Success);
+            }
+        }
+
+        assert(slab.usedSize() > 0 && slab.footprint() >= slab.usedSize() && slab.footprint() <= slab.budget());
+
+        for (size_t i = 0; i < composers.size(); ++i) {
+            assertSlabComposerData(composers[i], expected[i]);
+            unsigned char* composedData = nullptr;
+            size_t composedDataSize = 0;
+            assert(composers[i].compose(composedData, composedDataSize) == BufferComposerComposeStatus::Success);
+            assert(composedDataSize == expected[i].size() && std::memcmp(composedData, expected[i].data(), composedDataSize) == 0);
+            composers[i].cleanup();
+        }
+
+        // idle composers hold nothing, their blocks serve the next round
+        assert(slab.usedSize() == 0);
+        if (round == 0) {
+            roundFootprint = slab.footprint();
+        }
+        assert(slab.footprint() == roundFootprint);
+    }
+}
+
+void testComposerSlabBudget()
+{
+    using namespace restools;
+
+    // linear buffer
+    {
+        composer_slab slab(64 * 1024, 4096);
+        slab_buffer_composer<> composer(1024 * 1024, 1024 * 1024, slab_allocator<unsigned char>(slab));
+        std::vector<unsigned char> expected;
+
+        const std::vector<unsigned char> data = generateSlabData(1000, 1);
+        BufferComposerSaveStatus status = BufferComposerSaveStatus::Success;
+        while ((status = composer.save(data.data(), data.size())) == BufferComposerSaveStatus::Success) {
+            expected.insert(expected.end(), data.begin(), data.end());
+        }
+
+        assert(status == BufferComposerSaveStatus::MemoryBudgetIsExceeded);
+        assert(slab.footprint() <= slab.budget());
+        assertSlabComposerData(composer, expected);
+
+        unsigned char* reservedBuffer = nullptr;
+        assert(composer.reserve(data.size(), reservedBuffer) == BufferComposerSaveStatus::MemoryBudgetIsExceeded);
+        assert(composer.commit(0) == BufferComposerSaveStatus::Success);
+        assertSlabComposerData(composer, expected);
+
+        composer.cleanup();
+        assert(slab.usedSize() == 0);
+    }
+
+    // chunks, then a composition which does not fit the budget
+    {
+        composer_slab slab(320 * 1024);
+        slab_buffer_composer<> composer(256, 1024 * 1024, slab_allocator<unsigned char>(slab));
+        std::vector<unsigned char> expected;
+
+        BufferComposerSaveStatus status = BufferComposerSaveStatus::Success;
+        for (size_t i = 0; status == BufferComposerSaveStatus::Success; ++i) {
+            const std::vector<unsigned char> data = generateSlabData(700 + i % 5, i);
+            status = composer.save(data.data(), data.size());
+            if (status == BufferComposerSaveStatus::Success) {
+                expected.insert(expected.end(), data.begin(), data.end());
+            }
+        }
+
+        assert(status == BufferComposerSaveStatus::MemoryBudgetIsExceeded);
+        assertSlabComposerData(composer, expected);
+
+        unsigned char* composedData = nullptr;
+        size_t composedDataSize = 0;
+        assert(composer.compose(composedData, composedDataSize) == BufferComposerComposeStatus::MemoryBudgetIsExceeded);
+
+        // not composed, saves which fit the last chunk go on
+        const unsigned char byte = 7;
+        assert(composer.save(&byte, 1) == BufferComposerSaveStatus::Success);
+        expected.push_back(byte);
+        assertSlabComposerData(composer, expected);
+
+        composer.cleanup();
+        assert(slab.usedSize() == 0);
+    }
+
+    // stack data which cannot be copied out by release() stays saved
+    {
+        composer_slab slab(0);
+        slab_buffer_composer<> composer(256, 1024, slab_allocator<unsigned char>(slab));
+        const std::vector<unsigned char> data = generateSlabData(20, 3);
+        assert(composer.save(data.data(), data.size()) == BufferComposerSaveStatus::Success);
+
+        slab_buffer_composer<>::buffer_type releasedBuffer;
+        assert(composer.release(releasedBuffer) == BufferComposerComposeStatus::MemoryBudgetIsExceeded);
+        assert(!releasedBuffer.data());
+        assertSlabComposerData(composer, data);
+    }
+}
+
+void testComposerSlabReuse()
+{
+    using namespace restools;
+
+    // an emptied slab serves another block size
+    {
+        composer_slab slab(1024 * 1024);
+        std::vector<void*> blocks;
+        for (size_t i = 0; i < 1024; ++i) {
+            blocks.push_back(slab.allocate(64));
+        }
+        assert(slab.footprint() == 64 * 1024 && slab.pooledSize() == 0);
+
+        // one block keeps its slab
+        for (size_t i = 1; i < blocks.size(); ++i) {
+            slab.deallocate(blocks[i], 64);
+        }
+        assert(slab.pooledSize() == 0 && slab.usedSize() == 64);
+        slab.deallocate(blocks[0], 64);
+        assert(slab.pooledSize() == 64 * 1024 && slab.usedSize() == 0);
+
+        void* block = slab.allocate(4096);
+        assert(slab.footprint() == 64 * 1024 && slab.pooledSize() == 0);
+        slab.deallocate(block, 4096);
+
+        slab.trim();
+        assert(slab.footprint() == 0 && slab.pooledSize() == 0);
+    }
+
+    // pooled slabs go back to the heap before an allocation is refused
+    {
+        composer_slab slab(128 * 1024);
+        void* block = slab.allocate(64);
+        slab.deallocate(block, 64);
+        assert(slab.footprint() == 64 * 1024);
+
+        void* largeBlock = slab.allocate(100 * 1024);
+        assert(slab.footprint() == 100 * 1024 && slab.pooledSize() == 0);
+        slab.deallocate(largeBlock, 100 * 1024);
+        assert(slab.footprint() == 0);
+    }
+}
+
+void testSlabComposer()
+{
+    using namespace restools;
+
+    static_assert(sizeof(slab_composer<>) == 4 * sizeof(void*), "idle slab_composer is not compact");
+
+    composer_slab slab(1024 * 1024);
+    std::vector<slab_composer<>> composers;
+    for (size_t i = 0; i < 100; ++i) {
+        composers.emplace_back(1024, 65536, slab);
+    }
+    assert(slab.footprint() == 0);
+
+    std::vector<std::vector<unsigned char>> expected(composers.size());
+    for (size_t i = 0; i < composers.size(); ++i) {
+        expected[i] = generateSlabData(10 + i * 50, i);
+        for (size_t offset = 0; offset < expected[i].size(); offset += 100) {
+            const size_t size = std::min<size_t>(100, expected[i].size() - offset);
+            assert(composers[i].save(expected[i].data() + offset, size) == BufferComposerSaveStatus::Success);
+        }
+        assert(!composers[i].isIdle());
+    }
+
+    // moved composers keep their data
+    slab_composer<> moved(std::move(composers.back()));
+    assert(composers.back().isIdle() && composers.back().savedCount() == 0);
+    composers.back() = std::move(moved);
+
+    for (size_t i = 0; i < composers.size(); ++i) {
+        assertSlabComposerData(composers[i], expected[i]);
+        unsigned char* composedData = nullptr;
+        size_t composedDataSize = 0;
+        assert(composers[i].compose(composedData, composedDataSize) == BufferComposerComposeStatus::Success);
+        assert(composedDataSize == expected[i].size() && std::memcmp(composedData, expected[i].data(), composedDataSize) == 0);
+
+        // consuming everything returns the composer to the slab
+        assert(composers[i].consume(1) == BufferComposerConsumeStatus::Success);
+        assert(!composers[i].isIdle());
+        assert(composers[i].consume(composedDataSize - 1) == BufferComposerConsumeStatus::Success);
+        assert(composers[i].isIdle());
+    }
+    assert(slab.usedSize() == 0);
+
+    // a reservation committed empty holds nothing
+    unsigned char* reservedBuffer = nullptr;
+    assert(composers[0].reserve(100, reservedBuffer) == BufferComposerSaveStatus::Success);
+    assert(composers[0].commit(0) == BufferComposerSaveStatus::Success);
+    assert(composers[0].isIdle() && slab.usedSize() == 0);
+
+    // nothing left for the composer itself
+    composer_slab emptySlab(0);
+    slab_composer<> composer(1024, 65536, emptySlab);
+    const unsigned char byte = 1;
+    assert(composer.save(&byte, 1) == BufferComposerSaveStatus::MemoryBudgetIsExceeded);
+    assert(composer.isIdle());
+    unsigned char* composedData = nullptr;
+    size_t composedDataSize = 0;
+    assert(composer.compose(composedData, composedDataSize) == BufferComposerComposeStatus::NoDataSaved);
+}
+
+void testComposerSlab()
+{
+    testComposerSlabPooling();
+    testComposerSlabBudget();
+    testComposerSlabReuse();
+    testSlabComposer();
+}
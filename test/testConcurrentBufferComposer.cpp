@@ -0,0 +1,190 @@
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "restools/concurrent_buffer_composer.hpp"
+#include "restools/bytes_reader.hpp"
+#include "restools/bytes_writer.hpp"
+
+namespace
+{
+    static constexpr size_t fragmentHeaderSize = 1 + 4 + 2;
+
+    // Fragment: producer id, sequence number, payload size, payload filled with the producer id
+    size_t makeFragment(unsigned char* fragment, uint8_t producerId, uint32_t sequence)
+    {
+        const uint16_t payloadSize = static_cast<uint16_t>(sequence % 97);
+        restools::bytes_writer writer(fragment, fragmentHeaderSize + payloadSize);
+        writer.writeFast<std::endian::little>(producerId, sequence, payloadSize);
+        std::memset(writer.current(), producerId, payloadSize);
+        return fragmentHeaderSize + payloadSize;
+    }
+
+    // Returns fragments count per producer, asserting every fragment is complete and in order per producer
+    std::vector<uint32_t> parseFragments(const unsigned char* data, size_t size, size_t producersCount)
+    {
+        std::vector<uint32_t> fragmentsCount(producersCount, 0);
+        restools::bytes_reader reader(data, size);
+
+        while (reader.remaining() > 0) {
+            uint8_t producerId = 0;
+            uint32_t sequence = 0;
+            uint16_t payloadSize = 0;
+            assert(reader.read<std::endian::little>(producerId, sequence, payloadSize) == restools::BytesToTypeStatus::Success);
+            assert(producerId < producersCount && sequence == fragmentsCount[producerId]);
+            assert(reader.require(payloadSize) == restools::BytesToTypeStatus::Success);
+            for (size_t i = 0; i < payloadSize; ++i) {
+                assert(reader.current()[i] == producerId);
+            }
+            reader.skipFast(payloadSize);
+            ++fragmentsCount[producerId];
+        }
+
+        return fragmentsCount;
+    }
+}
+
+void testConcurrentBufferComposerProducers(size_t saveBufferMaxCount)
+{
+    using namespace restools;
+
+    static constexpr size_t producersCount = 4;
+    static constexpr uint32_t fragmentsPerProducer = 2000;
+
+    concurrent_buffer_composer<> composer(saveBufferMaxCount);
+
+    for (int round = 0; round < 2; ++round) {
+        std::vector<std::thread> producers;
+        std::vector<uint32_t> savedCount(producersCount, 0);
+
+        for (size_t producerId = 0; producerId < producersCount; ++producerId) {
+            producers.emplace_back([&composer, &savedCount, producerId]()
+            {
+                unsigned char fragment[fragmentHeaderSize + 128];
+                for (uint32_t sequence = 0; sequence < fragmentsPerProducer; ++sequence) {
+                    const size_t fragmentSize = makeFragment(fragment, static_cast<uint8_t>(producerId), savedCount[producerId]);
+
+                    BufferComposerSaveStatus status = BufferComposerSaveStatus::Success;
+                    if (sequence % 2 == 0) {
+                        status = composer.save(fragment, fragmentSize);
+                    }
+                    else {
+                        unsigned char* reservedBuffer = nullptr;
+                        status = composer.reserve(fragmentSize, reservedBuffer);
+                        if (status == BufferComposerSaveStatus::Success) {
+                            std::memcpy(reservedBuffer, fragment, fragmentSize);
+                            composer.commit(fragmentSize);
+                        }
+                    }
+
+                    if (status == BufferComposerSaveStatus::Success) {
+                        ++savedCount[producerId];
+                    }
+                    else {
+                        assert(status == BufferComposerSaveStatus::MaxSavedBufferCountLimited);
+                    }
+                }
+            });
+        }
+
+        for (std::thread& producer : producers) {
+            producer.join();
+        }
+
+        unsigned char* composedData = nullptr;
+        size_t composedDataSize = 0;
+        assert(composer.compose(composedData, composedDataSize) == BufferComposerComposeStatus::Success);
+        assert(composedDataSize <= saveBufferMaxCount);
+        assert(parseFragments(composedData, composedDataSize, producersCount) == savedCount);
+
+        unsigned char fragment[fragmentHeaderSize];
+        assert(composer.save(fragment, makeFragment(fragment, 0, 0)) == BufferComposerSaveStatus::NotClearedAfterCompose);
+
+        size_t recomposedDataSize = 0;
+        assert(composer.compose(composedData, recomposedDataSize) == BufferComposerComposeStatus::Success);
+        assert(recomposedDataSize == composedDataSize);
+
+        composer.clear();
+    }
+}
+
+void testConcurrentBufferComposerComposeWhileProducing()
+{
+    using namespace restools;
+
+    static constexpr size_t producersCount = 3;
+    concurrent_buffer_composer<> composer(16 * 1024 * 1024);
+
+    std::atomic<bool> composed = false;
+    std::vector<std::thread> producers;
+    for (size_t producerId = 0; producerId < producersCount; ++producerId) {
+        producers.emplace_back([&composer, &composed, producerId]()
+        {
+            unsigned char fragment[fragmentHeaderSize + 128];
+            uint32_t sequence = 0;
+            while (!composed.load()) {
+                const size_t fragmentSize = makeFragment(fragment, static_cast<uint8_t>(producerId), sequence);
+                const BufferComposerSaveStatus status = composer.save(fragment, fragmentSize);
+                if (status == BufferComposerSaveStatus::Success) {
+                    ++sequence;
+                }
+                else {
+                    assert(status == BufferComposerSaveStatus::NotClearedAfterCompose ||
+                        status == BufferComposerSaveStatus::MaxSavedBufferCountLimited);
+                }
+            }
+        });
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+    unsigned char* composedData = nullptr;
+    size_t composedDataSize = 0;
+    const BufferComposerComposeStatus status = composer.compose(composedData, composedDataSize);
+    composed.store(true);
+
+    for (std::thread& producer : producers) {
+        producer.join();
+    }
+
+    if (status == BufferComposerComposeStatus::Success) {
+        parseFragments(composedData, composedDataSize, producersCount);
+    }
+}
+
+void testConcurrentBufferComposer()
+{
+    using namespace restools;
+
+    concurrent_buffer_composer<> composer(16);
+    unsigned char* composedData = nullptr;
+    size_t composedDataSize = 0;
+    assert(composer.save(nullptr, 1) == BufferComposerSaveStatus::NullBuffer);
+    assert(composer.save(reinterpret_cast<const unsigned char*>(""), 0) == BufferComposerSaveStatus::ZeroBufferSize);
+    assert(composer.compose(composedData, composedDataSize) == BufferComposerComposeStatus::NoDataSaved);
+    composer.clear();
+    assert(composer.save(reinterpret_cast<const unsigned char*>("0123456789ABCDEFG"), 17) == BufferComposerSaveStatus::MaxSavedBufferCountLimited);
+    composer.clear();
+    assert(composer.save(reinterpret_cast<const unsigned char*>("0123456789"), 10) == BufferComposerSaveStatus::Success);
+    assert(composer.compose(composedData, composedDataSize) == BufferComposerComposeStatus::Success);
+    assert(composedDataSize == 10 && memcmp(composedData, "0123456789", 10) == 0);
+    composer.clear();
+    assert(composer.save(composedData, 1) == BufferComposerSaveStatus::BufferIsOverlapping);
+
+    // oversize ranges are refused without being claimed, huge ones do not reach the composed flag
+    unsigned char* reservedBuffer = nullptr;
+    assert(composer.reserve(SIZE_MAX, reservedBuffer) == BufferComposerSaveStatus::MaxSavedBufferCountLimited);
+    assert(composer.reserve(SIZE_MAX / 2 + 1, reservedBuffer) == BufferComposerSaveStatus::MaxSavedBufferCountLimited);
+    assert(composer.save(reinterpret_cast<const unsigned char*>("0123456789"), 10) == BufferComposerSaveStatus::Success);
+    assert(composer.save(reinterpret_cast<const unsigned char*>("0123456789"), 7) == BufferComposerSaveStatus::MaxSavedBufferCountLimited);
+    assert(composer.save(reinterpret_cast<const unsigned char*>("ABCDEF"), 6) == BufferComposerSaveStatus::Success);
+    assert(composer.compose(composedData, composedDataSize) == BufferComposerComposeStatus::Success);
+    assert(composedDataSize == 16 && memcmp(composedData, "0123456789ABCDEF", 16) == 0);
+    composer.clear();
+
+    testConcurrentBufferComposerProducers(4 * 2000 * (fragmentHeaderSize + 96));
+    testConcurrentBufferComposerProducers(64 * 1024);
+    testConcurrentBufferComposerComposeWhileProducing();
+}
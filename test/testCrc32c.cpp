@@ -0,0 +1,69 @@
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "restools/crc32c.hpp"
+
+namespace
+{
+    uint32_t crc32cBitwise(const unsigned char* data, size_t size)
+    {
+        uint32_t crc = 0xFFFFFFFF;
+        for (size_t i = 0; i < size; ++i) {
+            crc ^= data[i];
+            for (int bit = 0; bit < 8; ++bit) {
+                crc = (crc >> 1) ^ ((crc & 1) ? 0x82F63B78u : 0);
+            }
+        }
+        return ~crc;
+    }
+}
+
+void testCrc32cKernels(restools::detail::Crc32cKernel kernel, restools::detail::Crc32cCopyKernel copyKernel)
+{
+    const unsigned char check[] = "123456789";
+    assert(~kernel(~0u, check, 9) == 0xE3069283);
+
+    std::vector<unsigned char> data(300);
+    for (size_t i = 0; i < data.size(); ++i) {
+        data[i] = static_cast<unsigned char>(i * 31 + 7);
+    }
+
+    for (size_t offset = 0; offset < 8; ++offset) {
+        for (size_t size = 0; size + offset <= data.size(); size += 13) {
+            const uint32_t expectedCrc = crc32cBitwise(data.data() + offset, size);
+            assert(~kernel(~0u, data.data() + offset, size) == expectedCrc);
+
+            std::vector<unsigned char> copied(size + 1, 0xEE);
+            assert(~copyKernel(~0u, copied.data(), data.data() + offset, size) == expectedCrc);
+            assert(std::memcmp(copied.data(), data.data() + offset, size) == 0 && copied[size] == 0xEE);
+        }
+    }
+}
+
+void testCrc32c()
+{
+    using namespace restools;
+
+    static_assert(detail::CRC32C_TABLES[0][1] == 0xF26B8303);
+
+    testCrc32cKernels(&detail::crc32cScalar, &detail::crc32cCopyScalar);
+#if defined(RESTOOLS_X86)
+    if (cpuSupportsSse42()) {
+        testCrc32cKernels(&detail::crc32cSse42, &detail::crc32cCopySse42);
+    }
+#endif
+
+    // continuing a checksum
+    std::vector<unsigned char> data(1000);
+    for (size_t i = 0; i < data.size(); ++i) {
+        data[i] = static_cast<unsigned char>(i ^ (i >> 3));
+    }
+    std::vector<unsigned char> copied(data.size());
+    uint32_t crc = crc32c(data.data(), 100);
+    crc = crc32cCopy(copied.data() + 100, data.data() + 100, 333, crc);
+    crc = crc32c(data.data() + 433, data.size() - 433, crc);
+    assert(crc == crc32c(data.data(), data.size()) && crc == crc32cBitwise(data.data(), data.size()));
+    assert(std::memcmp(copied.data() + 100, data.data() + 100, 333) == 0);
+}
@@ -0,0 +1,147 @@
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "restools/composer_slab.hpp"
+#include "restools/frame_extractor.hpp"
+#include "restools/bytes_writer.hpp"
+
+namespace
+{
+    template <typename LENGTH_TYPE, std::endian LENGTH_ENDIAN>
+    std::vector<unsigned char> makeFramesStream(const std::vector<size_t>& frameSizes)
+    {
+        std::vector<unsigned char> stream;
+        for (size_t frameIndex = 0; frameIndex < frameSizes.size(); ++frameIndex) {
+            unsigned char header[sizeof(LENGTH_TYPE)];
+            restools::typeToBytesFast<LENGTH_ENDIAN>(static_cast<LENGTH_TYPE>(frameSizes[frameIndex]), header);
+            stream.insert(stream.end(), header, header + sizeof(header));
+            for (size_t i = 0; i < frameSizes[frameIndex]; ++i) {
+                stream.push_back(static_cast<unsigned char>(frameIndex + i));
+            }
+        }
+        return stream;
+    }
+
+    void assertFrame(const unsigned char* frame, size_t frameSize, size_t frameIndex, size_t expectedFrameSize)
+    {
+        assert(frameSize == expectedFrameSize);
+        for (size_t i = 0; i < frameSize; ++i) {
+            assert(frame[i] == static_cast<unsigned char>(frameIndex + i));
+        }
+    }
+}
+
+template <typename LENGTH_TYPE, std::endian LENGTH_ENDIAN>
+void testFrameExtractorStream(size_t receiveSize)
+{
+    using namespace restools;
+
+    const size_t largeFrameSize = sizeof(LENGTH_TYPE) == 1 ? 255 : 5000;
+    const std::vector<size_t> frameSizes = { 0, 1, 5, 40, 200, 2, largeFrameSize, 7, 64, 1, 255, 3 };
+    const std::vector<unsigned char> stream = makeFramesStream<LENGTH_TYPE, LENGTH_ENDIAN>(frameSizes);
+
+    frame_extractor<LENGTH_TYPE, LENGTH_ENDIAN, buffer_composer<16, 2, 256>> extractor(8192, 128, 16384);
+
+    size_t streamOffset = 0;
+    size_t frameIndex = 0;
+    while (frameIndex < frameSizes.size()) {
+        const unsigned char* frame = nullptr;
+        size_t frameSize = 0;
+        FrameExtractorStatus status = extractor.next(frame, frameSize);
+
+        if (status == FrameExtractorStatus::Success) {
+            assertFrame(frame, frameSize, frameIndex, frameSizes[frameIndex]);
+            ++frameIndex;
+            continue;
+        }
+
+        assert(status == FrameExtractorStatus::NeedMoreData && streamOffset < stream.size());
+
+        // receive straight into the composer
+        const size_t receivedSize = std::min(receiveSize, stream.size() - streamOffset);
+        unsigned char* reservedBuffer = nullptr;
+        assert(extractor.composer().reserve(receiveSize, reservedBuffer) == BufferComposerSaveStatus::Success);
+        std::memcpy(reservedBuffer, stream.data() + streamOffset, receivedSize);
+        assert(extractor.composer().commit(receivedSize) == BufferComposerSaveStatus::Success);
+        streamOffset += receivedSize;
+    }
+
+    const unsigned char* frame = nullptr;
+    size_t frameSize = 0;
+    assert(extractor.next(frame, frameSize) == FrameExtractorStatus::NeedMoreData);
+    assert(streamOffset == stream.size() && extractor.composer().savedCount() == 0);
+}
+
+void testFrameExtractorTooLarge()
+{
+    using namespace restools;
+
+    frame_extractor<uint16_t, std::endian::little, buffer_composer<8, 2>> extractor(16, 64, 256);
+    const std::vector<unsigned char> stream = makeFramesStream<uint16_t, std::endian::little>({ 16, 17 });
+    assert(extractor.composer().save(stream.data(), stream.size()) == BufferComposerSaveStatus::Success);
+
+    const unsigned char* frame = nullptr;
+    size_t frameSize = 0;
+    assert(extractor.next(frame, frameSize) == FrameExtractorStatus::Success);
+    assertFrame(frame, frameSize, 0, 16);
+    assert(extractor.next(frame, frameSize) == FrameExtractorStatus::FrameIsTooLarge);
+    assert(extractor.next(frame, frameSize) == FrameExtractorStatus::FrameIsTooLarge);
+
+    extractor.clear();
+    assert(extractor.next(frame, frameSize) == FrameExtractorStatus::NeedMoreData);
+}
+
+void testFrameExtractorFailures()
+{
+    using namespace restools;
+
+    const unsigned char* frame = nullptr;
+    size_t frameSize = 0;
+
+    // a frame split between the stack buffer and a chunk, its scratch copy is over the budget
+    {
+        composer_slab slab(200 * 1024);
+        frame_extractor<uint32_t, std::endian::big, slab_buffer_composer<>> extractor(1024 * 1024,
+            256, 1024 * 1024, slab_allocator<unsigned char>(slab));
+        const std::vector<unsigned char> stream = makeFramesStream<uint32_t, std::endian::big>({ 100 * 1024 + 16 });
+        assert(extractor.composer().save(stream.data(), 20) == BufferComposerSaveStatus::Success);
+        assert(extractor.composer().save(stream.data() + 20, stream.size() - 20) == BufferComposerSaveStatus::Success);
+
+        assert(extractor.next(frame, frameSize) == FrameExtractorStatus::MemoryBudgetIsExceeded);
+        assert(extractor.next(frame, frameSize) == FrameExtractorStatus::MemoryBudgetIsExceeded);
+        assert(extractor.composer().savedCount() == stream.size());
+    }
+
+    // the yielded frame cannot be consumed while a reserve() is not committed
+    {
+        frame_extractor<uint8_t, std::endian::big, buffer_composer<8, 2>> extractor(16, 64, 256);
+        const std::vector<unsigned char> stream = makeFramesStream<uint8_t, std::endian::big>({ 5, 6 });
+        assert(extractor.composer().save(stream.data(), stream.size()) == BufferComposerSaveStatus::Success);
+        assert(extractor.next(frame, frameSize) == FrameExtractorStatus::Success);
+
+        unsigned char* reservedBuffer = nullptr;
+        assert(extractor.composer().reserve(10, reservedBuffer) == BufferComposerSaveStatus::Success);
+        assert(extractor.next(frame, frameSize) == FrameExtractorStatus::ConsumeIsFailed);
+        assert(extractor.composer().commit(0) == BufferComposerSaveStatus::Success);
+
+        assert(extractor.next(frame, frameSize) == FrameExtractorStatus::Success);
+        assertFrame(frame, frameSize, 1, 6);
+    }
+}
+
+void testFrameExtractor()
+{
+    using namespace restools;
+
+    for (size_t receiveSize : { 1, 3, 16, 100, 1000, 4096 }) {
+        testFrameExtractorStream<uint8_t, std::endian::big>(receiveSize);
+        testFrameExtractorStream<uint16_t, std::endian::big>(receiveSize);
+        testFrameExtractorStream<uint32_t, std::endian::little>(receiveSize);
+        testFrameExtractorStream<uint64_t, std::endian::big>(receiveSize);
+    }
+
+    testFrameExtractorTooLarge();
+    testFrameExtractorFailures();
+}
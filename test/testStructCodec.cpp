@@ -0,0 +1,115 @@
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+
+#include "restools/struct_codec.hpp"
+
+namespace
+{
+    enum class TestSide : uint8_t
+    {
+        Buy = 'B',
+        Sell = 'S',
+    };
+
+    struct TestOrder
+    {
+        char symbol[4] = { 0 };
+        TestSide side = TestSide::Buy;
+        uint16_t flags = 0;
+        int32_t quantity = 0;
+        uint64_t orderId = 0;
+        double price = 0;
+        uint16_t levels[2] = { 0 };
+    };
+
+    using TestOrderCodec = restools::struct_codec<TestOrder,
+        restools::struct_field<&TestOrder::symbol>,
+        restools::struct_field<&TestOrder::side>,
+        restools::struct_padding<1>,
+        restools::struct_field<&TestOrder::flags, std::endian::little>,
+        restools::struct_field<&TestOrder::quantity, std::endian::big>,
+        restools::struct_field<&TestOrder::orderId, std::endian::big>,
+        restools::struct_field<&TestOrder::price, std::endian::big>,
+        restools::struct_field<&TestOrder::levels, std::endian::big>>;
+}
+
+void testStructCodecLayout()
+{
+    using namespace restools;
+
+    static_assert(TestOrderCodec::wireSize == 4 + 1 + 1 + 2 + 4 + 8 + 8 + 4);
+
+    TestOrder order;
+    std::memcpy(order.symbol, "ABCD", 4);
+    order.side = TestSide::Sell;
+    order.flags = 0x0102;
+    order.quantity = -2;
+    order.orderId = 0x0123456789ABCDEFull;
+    order.price = 1.5;
+    order.levels[0] = 0x0A0B;
+    order.levels[1] = 0x0C0D;
+
+    unsigned char wireBytes[TestOrderCodec::wireSize];
+    std::memset(wireBytes, 0xEE, sizeof(wireBytes));
+    assert(TestOrderCodec::encode(order, wireBytes, sizeof(wireBytes)) == TypeToByteStatus::Success);
+
+    static constexpr unsigned char expectedBytes[] = {
+        'A', 'B', 'C', 'D',
+        'S',
+        0x00,
+        0x02, 0x01,
+        0xFF, 0xFF, 0xFF, 0xFE,
+        0x01, 0x23, 0x45, 0x67, 0x89, 0xAB, 0xCD, 0xEF,
+        0x3F, 0xF8, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x0A, 0x0B, 0x0C, 0x0D };
+    static_assert(sizeof(expectedBytes) == TestOrderCodec::wireSize);
+    assert(memcmp(wireBytes, expectedBytes, sizeof(expectedBytes)) == 0);
+
+    TestOrder decodedOrder;
+    assert(TestOrderCodec::decode(wireBytes, sizeof(wireBytes), decodedOrder) == BytesToTypeStatus::Success);
+    assert(memcmp(decodedOrder.symbol, "ABCD", 4) == 0 && decodedOrder.side == TestSide::Sell);
+    assert(decodedOrder.flags == order.flags && decodedOrder.quantity == order.quantity);
+    assert(decodedOrder.orderId == order.orderId && decodedOrder.price == order.price);
+    assert(decodedOrder.levels[0] == order.levels[0] && decodedOrder.levels[1] == order.levels[1]);
+
+    assert(TestOrderCodec::encode(order, wireBytes, sizeof(wireBytes) - 1) == TypeToByteStatus::BufferIsOverflow);
+    assert(TestOrderCodec::decode(wireBytes, sizeof(wireBytes) - 1, decodedOrder) == BytesToTypeStatus::BufferIsOverflow);
+
+    unsigned char* orderAsBytes = reinterpret_cast<unsigned char*>(&order);
+    assert(TestOrderCodec::encode(order, orderAsBytes, TestOrderCodec::wireSize) == TypeToByteStatus::BufferIsOverlapping);
+    assert(TestOrderCodec::decode(orderAsBytes, TestOrderCodec::wireSize, order) == BytesToTypeStatus::BufferIsOverlapping);
+}
+
+void testStructCodecCursors()
+{
+    using namespace restools;
+
+    static constexpr size_t ordersCount = 3;
+    unsigned char wireBytes[ordersCount * TestOrderCodec::wireSize + 2];
+
+    bytes_writer writer(wireBytes, sizeof(wireBytes));
+    for (size_t i = 0; i < ordersCount; ++i) {
+        TestOrder order;
+        order.quantity = static_cast<int32_t>(i * 100);
+        order.orderId = i;
+        assert(TestOrderCodec::encode(order, writer) == TypeToByteStatus::Success);
+    }
+    assert(TestOrderCodec::encode(TestOrder(), writer) == TypeToByteStatus::BufferIsOverflow);
+    assert(writer.position() == ordersCount * TestOrderCodec::wireSize);
+
+    bytes_reader reader(wireBytes, writer.position());
+    for (size_t i = 0; i < ordersCount; ++i) {
+        TestOrder order;
+        assert(TestOrderCodec::decode(reader, order) == BytesToTypeStatus::Success);
+        assert(order.quantity == static_cast<int32_t>(i * 100) && order.orderId == i);
+    }
+    TestOrder order;
+    assert(TestOrderCodec::decode(reader, order) == BytesToTypeStatus::BufferIsOverflow);
+}
+
+void testStructCodec()
+{
+    testStructCodecLayout();
+    testStructCodecCursors();
+}
@@ -0,0 +1,161 @@
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "restools/varint.hpp"
+#include "restools/bytes_reader.hpp"
+#include "restools/bytes_writer.hpp"
+
+template <typename T>
+void testVarintRoundTrip(T value)
+{
+    using namespace restools;
+
+    // exact buffer goes through the scalar decoder, padded one through the word decoder
+    for (size_t padding : { 0, 8 }) {
+        std::vector<unsigned char> bytes(VARINT_MAX_SIZE<T> + padding, 0xEE);
+        size_t writtenSize = 0;
+        assert(varintToBytesSafe(value, bytes.data(), bytes.size(), writtenSize) == TypeToByteStatus::Success);
+        assert(writtenSize == varintSize(value) && writtenSize <= VARINT_MAX_SIZE<T>);
+
+        T decodedValue = 0;
+        size_t readSize = 0;
+        assert(bytesToVarintSafe(bytes.data(), writtenSize + padding, decodedValue, readSize) == BytesToTypeStatus::Success);
+        assert(decodedValue == value && readSize == writtenSize);
+
+        assert(bytesToVarintSafe(bytes.data(), writtenSize - 1, decodedValue, readSize) == BytesToTypeStatus::BufferIsOverflow);
+        assert(varintToBytesSafe(value, bytes.data(), writtenSize - 1, writtenSize) == TypeToByteStatus::BufferIsOverflow);
+    }
+}
+
+template <typename T>
+void testVarintRoundTrips()
+{
+    std::mt19937_64 generator(7);
+
+    for (T value : { std::numeric_limits<T>::min(), std::numeric_limits<T>::max(), T(0), T(1), T(127), T(-1) }) {
+        testVarintRoundTrip(value);
+    }
+
+    for (unsigned shift = 0; shift < sizeof(T) * 8; ++shift) {
+        testVarintRoundTrip(static_cast<T>(uint64_t(1) << shift));
+        testVarintRoundTrip(static_cast<T>((uint64_t(1) << shift) - 1));
+        testVarintRoundTrip(static_cast<T>(generator() >> (63 - shift)));
+    }
+}
+
+void testVarintMalformed()
+{
+    using namespace restools;
+
+    for (size_t padding : { 0, 8 }) {
+        uint32_t value32 = 0;
+        uint64_t value64 = 0;
+        int16_t value16 = 0;
+        size_t readSize = 0;
+
+        std::vector<unsigned char> overlong = { 0x80, 0x80, 0x80, 0x80, 0x80, 0x00 };
+        overlong.resize(overlong.size() + padding);
+        assert(bytesToVarintSafe(overlong.data(), overlong.size(), value32, readSize) == BytesToTypeStatus::VarintIsMalformed);
+
+        std::vector<unsigned char> aboveUint32 = { 0xFF, 0xFF, 0xFF, 0xFF, 0x1F };
+        aboveUint32.resize(aboveUint32.size() + padding);
+        assert(bytesToVarintSafe(aboveUint32.data(), aboveUint32.size(), value32, readSize) == BytesToTypeStatus::VarintIsMalformed);
+        aboveUint32[4] = 0x0F;
+        assert(bytesToVarintSafe(aboveUint32.data(), aboveUint32.size(), value32, readSize) == BytesToTypeStatus::Success);
+        assert(value32 == std::numeric_limits<uint32_t>::max() && readSize == 5);
+
+        std::vector<unsigned char> aboveUint64 = { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x02 };
+        aboveUint64.resize(aboveUint64.size() + padding);
+        assert(bytesToVarintSafe(aboveUint64.data(), aboveUint64.size(), value64, readSize) == BytesToTypeStatus::VarintIsMalformed);
+        aboveUint64[9] = 0x01;
+        assert(bytesToVarintSafe(aboveUint64.data(), aboveUint64.size(), value64, readSize) == BytesToTypeStatus::Success);
+        assert(value64 == std::numeric_limits<uint64_t>::max() && readSize == 10);
+
+        std::vector<unsigned char> aboveInt16 = { 0xFF, 0xFF, 0x04 };
+        aboveInt16.resize(aboveInt16.size() + padding);
+        assert(bytesToVarintSafe(aboveInt16.data(), aboveInt16.size(), value16, readSize) == BytesToTypeStatus::VarintIsMalformed);
+    }
+}
+
+void testVarintArray()
+{
+    using namespace restools;
+
+    std::mt19937_64 generator(11);
+    std::vector<int64_t> values(3000);
+    for (size_t i = 0; i < values.size(); ++i) {
+        // runs of one-byte values between larger ones
+        const unsigned bits = (i / 40) % 3 == 0 ? static_cast<unsigned>(generator() % 64) : 5;
+        values[i] = static_cast<int64_t>(generator() >> (63 - bits)) * ((generator() & 1) ? 1 : -1);
+    }
+
+    std::vector<unsigned char> bytes(values.size() * VARINT_MAX_SIZE<int64_t>);
+    size_t writtenSize = 0;
+    assert(varintToBytesArraySafe(values.data(), values.size(), bytes.data(), bytes.size(), writtenSize) == TypeToByteStatus::Success);
+
+    size_t expectedSize = 0;
+    for (int64_t value : values) {
+        expectedSize += varintSize(value);
+    }
+    assert(writtenSize == expectedSize);
+
+    for (size_t count : { size_t(0), size_t(1), size_t(7), size_t(100), values.size() }) {
+        std::vector<int64_t> decodedValues(count);
+        size_t readSize = 0;
+        assert(bytesToVarintArraySafe(bytes.data(), writtenSize, decodedValues.data(), count, readSize) == BytesToTypeStatus::Success);
+        assert(std::equal(decodedValues.begin(), decodedValues.end(), values.begin()));
+        assert(count != values.size() || readSize == writtenSize);
+    }
+
+    // truncated stream reports the decoded prefix
+    std::vector<int64_t> decodedValues(values.size());
+    size_t readSize = 0;
+    assert(bytesToVarintArraySafe(bytes.data(), writtenSize - 1, decodedValues.data(), values.size(), readSize) ==
+        BytesToTypeStatus::BufferIsOverflow);
+    assert(readSize == writtenSize - varintSize(values.back()));
+
+    size_t shortWrittenSize = 0;
+    assert(varintToBytesArraySafe(values.data(), values.size(), bytes.data(), writtenSize - 1, shortWrittenSize) ==
+        TypeToByteStatus::BufferIsOverflow);
+    assert(shortWrittenSize == readSize);
+
+    // cursors
+    unsigned char cursorBytes[32];
+    bytes_writer writer(cursorBytes, sizeof(cursorBytes));
+    const uint32_t cursorValues[] = { 300, 1, 0xFFFFFFFF };
+    assert(writer.writeVarint(int8_t(-64)) == TypeToByteStatus::Success);
+    assert(writer.writeVarintArray(cursorValues, 3) == TypeToByteStatus::Success);
+    assert(writer.position() == 1 + 2 + 1 + 5 && cursorBytes[1] == 0xAC && cursorBytes[2] == 0x02);
+
+    bytes_reader reader(cursorBytes, writer.position());
+    int8_t smallValue = 0;
+    uint32_t readValues[3] = {};
+    assert(reader.readVarint(smallValue) == BytesToTypeStatus::Success && smallValue == -64);
+    assert(reader.readVarintArray(readValues, 3) == BytesToTypeStatus::Success);
+    assert(std::equal(readValues, readValues + 3, cursorValues) && reader.remaining() == 0);
+    assert(reader.readVarint(smallValue) == BytesToTypeStatus::BufferIsOverflow);
+}
+
+void testVarint()
+{
+    using namespace restools;
+
+    static_assert(zigzagEncode<int32_t>(0) == 0 && zigzagEncode<int32_t>(-1) == 1 && zigzagEncode<int32_t>(1) == 2);
+    static_assert(zigzagEncode<int32_t>(std::numeric_limits<int32_t>::min()) == 0xFFFFFFFFu);
+    static_assert(zigzagDecode<int16_t>(3) == -2 && zigzagDecode<int8_t>(0xFF) == -128);
+    static_assert(varintSize(uint32_t(127)) == 1 && varintSize(uint32_t(128)) == 2 && varintSize(uint64_t(~0ull)) == 10);
+
+    testVarintRoundTrips<uint8_t>();
+    testVarintRoundTrips<uint16_t>();
+    testVarintRoundTrips<uint32_t>();
+    testVarintRoundTrips<uint64_t>();
+    testVarintRoundTrips<int8_t>();
+    testVarintRoundTrips<int16_t>();
+    testVarintRoundTrips<int32_t>();
+    testVarintRoundTrips<int64_t>();
+    testVarintMalformed();
+    testVarintArray();
+}